@@ -1,6 +1,11 @@
 #version 330 core
 /* ----- Uniforms ----- */
-uniform float time;
+// Per-frame constants, shared by every shader
+layout (std140) uniform FrameData {
+	mat4 P;
+	mat4 V;
+	float time;
+};
 
 /* ----- In/Out ----- */
 // frag shader must ALWAYS output a vec4 for color
@@ -2,17 +2,25 @@
 #version 330 core
 
 /* ----- Attributes ----- */
-// Note: aPos is declared as a vec4 here, but it is sent as a vec3. OpenGL automatically
-// adds a 'w' value of 1.0
+// Note: aPos is declared as a vec4 here. Full vertices send it as a vec3, and OpenGL
+// automatically adds a 'w' value of 1.0. Packed vertices send normalized shorts (with
+// w = 1) that iMv scales back up, and normals & tex coords are unpacked the same way, so
+// these declarations work for either MeshArena vertex format
 layout (location = 0) in vec4 aPos;
+// Per-instance modelview matrix (Mv = V * M), from the RenderQueue
+layout (location = 3) in mat4 iMv;
 
 /* ----- Uniforms ----- */
-// Model, view, and projection matrices
-uniform mat4 Mvp;
+// Per-frame constants, shared by every shader
+layout (std140) uniform FrameData {
+	mat4 P;
+	mat4 V;
+	float time;
+};
 
 /* ----- Outputs ----- */
 
 void main() {
 	// gl_Position is a built-in variable, and the final output of a vertex shader
-	gl_Position = Mvp * aPos;
+	gl_Position = P * iMv * aPos;
 }
\ No newline at end of file
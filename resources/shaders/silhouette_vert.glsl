@@ -2,17 +2,25 @@
 #version 330 core
 
 /* ----- Attributes ----- */
-// Note: aPos is declared as a vec4 here, but it is sent as a vec3. OpenGL automatically
-// adds a 'w' value of 1.0
+// Note: aPos is declared as a vec4 here. Full vertices send it as a vec3, and OpenGL
+// automatically adds a 'w' value of 1.0. Packed vertices send normalized shorts (with
+// w = 1) that iMv scales back up, and normals & tex coords are unpacked the same way, so
+// these declarations work for either MeshArena vertex format
 layout (location = 0) in vec4 aPos;
 layout (location = 1) in vec3 aNor;
 layout (location = 2) in vec2 aTexCoord;
+// Per-instance modelview matrix (Mv = V * M) and its inverse transpose for normals, from
+//   the RenderQueue
+layout (location = 3) in mat4 iMv;
+layout (location = 7) in mat3 iMv_invT;
 
 /* ----- Uniforms ----- */
-// Modelview and projection matrices, where Mv = V * M
-uniform mat4 Mv;
-uniform mat4 Mv_invT;
-uniform mat4 P;
+// Per-frame constants, shared by every shader
+layout (std140) uniform FrameData {
+	mat4 P;
+	mat4 V;
+	float time;
+};
 
 /* ----- Outputs ----- */
 out vertexInfo {
@@ -23,8 +31,7 @@ out vertexInfo {
 
 void main() {
 	// Position in eye coordinates, used for finding silhouettes
-	position = Mv * aPos;
+	position = iMv * aPos;
 	gl_Position = P * position;
-	vec4 n = vec4(aNor, 0.0);
-	normal = (Mv_invT * n).xyz;
+	normal = iMv_invT * aNor;
 }
\ No newline at end of file
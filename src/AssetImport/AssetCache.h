@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Assets are looked up by a hash of their path, so the path is only hashed once per
+//   request. A 64-bit hash makes collisions between real paths vanishingly unlikely, so
+//   the path itself is only compared in debug builds, to catch one if it ever happens
+typedef uint64_t AssetID;
+
+// 64-bit FNV-1a hash of an asset's path
+inline AssetID HashAssetPath(const std::string& path) {
+	AssetID hash = 14695981039346656037ull;
+	for (const char c : path) {
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+///
+/// Reference-counted cache of loaded assets (Models or Textures). The cache keeps a
+/// reference to every asset, and an asset is in use while anything else holds one too (i.e.
+/// a ModelObject holding its Model, or a StaticMesh holding its Textures).
+///
+/// Assets that nothing uses anymore stay cached, so they're free to request again, until
+/// the cache's total size goes over its budget. Then Trim frees the unused assets that have
+/// gone longest without being used. Assets that are in use are never freed, so the budget
+/// can be exceeded if everything is in use.
+///
+/// T must provide GetNumBytes(), the memory held by the asset (0 while it's loading).
+///
+template <typename T>
+class AssetCache {
+public:
+	// budget is the total size, in bytes, of every cached asset, whether it's in use or
+	//   not. Only unused assets are freed to get back under it
+	explicit AssetCache(const size_t budget) :
+		budget(budget) {}
+
+	// Find an asset, counting the request as a use. Returns null if it isn't cached.
+	//   id must be HashAssetPath(path)
+	std::shared_ptr<T> Find(const AssetID id, const std::string& path) {
+		auto it = entries.find(id);
+		if (it == entries.end()) {
+			return nullptr;
+		}
+		assert(it->second.path == path && "Two asset paths have the same AssetID");
+		it->second.lastUsed = currentTick;
+		return it->second.asset;
+	}
+	// Add an asset that Find didn't have. Pinned assets are never freed
+	void Insert(const AssetID id, const std::string& path, const std::shared_ptr<T>& asset,
+	            const bool pinned = false) {
+		Entry& entry = entries[id];
+		assert((entry.path.empty() || entry.path == path) &&
+		       "Two asset paths have the same AssetID");
+		entry.path = path;
+		entry.asset = asset;
+		entry.lastUsed = currentTick;
+		entry.pinned = pinned;
+	}
+	// Free unused assets, least recently used first, until the cache fits in its budget.
+	//   Returns the number of assets that were freed
+	size_t Trim() {
+		++currentTick;
+		totalBytes = 0;
+		std::vector<std::pair<uint64_t, AssetID> > unused;
+		for (auto& id_and_entry : entries) {
+			Entry& entry = id_and_entry.second;
+			totalBytes += entry.asset->GetNumBytes();
+			if (entry.pinned || entry.asset.use_count() > 1) {
+				entry.lastUsed = currentTick;
+			}
+			else {
+				unused.emplace_back(entry.lastUsed, id_and_entry.first);
+			}
+		}
+		if (totalBytes <= budget) {
+			return 0;
+		}
+		std::sort(unused.begin(), unused.end());
+		size_t num_freed = 0;
+		for (const std::pair<uint64_t, AssetID>& lru_entry : unused) {
+			if (totalBytes <= budget) {
+				break;
+			}
+			auto it = entries.find(lru_entry.second);
+			totalBytes -= it->second.asset->GetNumBytes();
+			entries.erase(it);
+			++num_freed;
+		}
+		return num_freed;
+	}
+
+	/* ----- Getters ----- */
+	size_t GetNumAssets() const { return entries.size(); }
+	// Total size of every cached asset, as of the last Trim
+	size_t GetNumBytes() const { return totalBytes; }
+
+private:
+	struct Entry {
+		std::shared_ptr<T> asset;
+		// Path the asset was requested with, for checking the AssetID in debug builds
+		std::string path;
+		// Value of currentTick when the asset was last requested or in use
+		uint64_t lastUsed = 0;
+		bool pinned = false;
+	};
+
+	std::unordered_map<AssetID, Entry> entries;
+	const size_t budget;
+	size_t totalBytes = 0;
+	// Advances on every Trim, so it counts frames when Trim is called once per frame
+	uint64_t currentTick = 0;
+};
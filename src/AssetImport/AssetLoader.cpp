@@ -0,0 +1,127 @@
+#include <algorithm>
+
+#include "AssetLoader.h"
+#include "Model.h"
+#include "Texture.h"
+
+AssetLoader::AssetLoader(size_t num_workers, const size_t upload_budget) :
+	uploadBudget(upload_budget) {
+	if (num_workers == 0) {
+		// hardware_concurrency can return 0 if it isn't known
+		num_workers = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	}
+	for (size_t i = 0; i < num_workers; ++i) {
+		workers.emplace_back(&AssetLoader::WorkerLoop, this);
+	}
+}
+
+AssetLoader::~AssetLoader() {
+	// Files that haven't been read yet are dropped, and a worker in the middle of one
+	//   finishes it first
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+	}
+	jobCondition.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void AssetLoader::LoadModel(const std::shared_ptr<Model>& model, const std::string& filename,
+                            std::weak_ptr<Scene> scene_ref) {
+	std::weak_ptr<Model> model_ref = model;
+	const VertexFormat vertex_format = model->GetVertexFormat();
+	++numPending;
+	QueueJob([this, model_ref, filename, vertex_format, scene_ref]() {
+		// Skip the read if the model was released while it was waiting
+		if (model_ref.expired()) {
+			--numPending;
+			return;
+		}
+		// Shared, since std::function needs a copyable lambda
+		std::shared_ptr<Model::ModelData> data = Model::ReadFile(filename, vertex_format);
+		const size_t num_bytes = data->GetNumBytes();
+		QueueUpload([model_ref, data, scene_ref]() {
+			if (std::shared_ptr<Model> loaded_model = model_ref.lock()) {
+				loaded_model->Upload(*data, scene_ref);
+			}
+		}, num_bytes);
+	});
+}
+
+void AssetLoader::LoadTexture(const std::shared_ptr<Texture>& texture,
+                              const std::string& filename) {
+	std::weak_ptr<Texture> texture_ref = texture;
+	const TextureOptions options = texture->GetOptions();
+	++numPending;
+	QueueJob([this, texture_ref, filename, options]() {
+		if (texture_ref.expired()) {
+			--numPending;
+			return;
+		}
+		std::shared_ptr<Texture::ImageData> image = Texture::ReadFile(filename, options);
+		const size_t num_bytes = image->GetNumBytes();
+		QueueUpload([texture_ref, image]() {
+			if (std::shared_ptr<Texture> loaded_texture = texture_ref.lock()) {
+				loaded_texture->Upload(*image);
+			}
+		}, num_bytes);
+	});
+}
+
+size_t AssetLoader::ProcessUploads() {
+	size_t num_uploaded = 0;
+	size_t num_bytes = 0;
+	// Always run at least one upload, so that an asset bigger than the whole budget still
+	//   gets through
+	while (num_uploaded == 0 || num_bytes < uploadBudget) {
+		Upload next;
+		{
+			std::lock_guard<std::mutex> lock(uploadMutex);
+			if (uploads.empty()) {
+				break;
+			}
+			next = std::move(uploads.front());
+			uploads.pop_front();
+		}
+		// Run without the lock, since a model's upload can queue loads for its textures
+		next.upload();
+		num_bytes += next.numBytes;
+		++num_uploaded;
+		--numPending;
+	}
+	return num_uploaded;
+}
+
+void AssetLoader::QueueJob(Job job) {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.emplace_back(std::move(job));
+	}
+	jobCondition.notify_one();
+}
+
+void AssetLoader::QueueUpload(Job upload, const size_t num_bytes) {
+	Upload new_upload;
+	new_upload.upload = std::move(upload);
+	new_upload.numBytes = num_bytes;
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	uploads.emplace_back(std::move(new_upload));
+}
+
+void AssetLoader::WorkerLoop() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
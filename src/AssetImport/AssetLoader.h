@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Model;
+class Scene;
+class Texture;
+
+///
+/// Loads models & textures in the background. Worker threads read and decode files (which
+/// doesn't need OpenGL), then queue an upload for the GL thread. The GL thread runs the
+/// queued uploads once per frame until a byte budget is spent, so a burst of finished
+/// loads is spread over several frames instead of stalling one.
+///
+/// Assets are created empty and filled in by their upload, so the scene can reference them
+/// right away. Loads only hold weak references, so an asset that's released before it
+/// finishes loading is dropped.
+///
+/// Uses its own threads instead of the JobSystem, since the physics update waits on the
+/// JobSystem and would end up running long file reads.
+///
+class AssetLoader {
+public:
+	// Start num_workers threads. 0 uses half of the hardware threads, leaving the rest for
+	//   rendering & physics. upload_budget is the number of bytes uploaded per frame
+	AssetLoader(size_t num_workers, const size_t upload_budget);
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Read a model file in the background, then fill in 'model'. Its textures are loaded
+	//   through the scene when it's uploaded
+	void LoadModel(const std::shared_ptr<Model>& model, const std::string& filename,
+	               std::weak_ptr<Scene> scene_ref);
+	// Decode an image file in the background, then fill in 'texture'
+	void LoadTexture(const std::shared_ptr<Texture>& texture, const std::string& filename);
+	// Run finished loads' uploads until this frame's budget is spent. Must be called on the
+	//   GL thread. Returns the number of assets that were uploaded
+	size_t ProcessUploads();
+
+	/* ----- Getters ----- */
+	// Number of assets that are still being read or waiting to be uploaded
+	size_t GetNumPending() const { return numPending; }
+
+private:
+	typedef std::function<void()> Job;
+	struct Upload {
+		Job upload;
+		// Size of the data that the upload sends to the GPU
+		size_t numBytes = 0;
+	};
+
+	void QueueJob(Job job);
+	void QueueUpload(Job upload, const size_t num_bytes);
+	void WorkerLoop();
+
+	const size_t uploadBudget;
+	std::vector<std::thread> workers;
+
+	/* ----- Files waiting to be read ----- */
+	std::deque<Job> jobs;
+	std::mutex jobMutex;
+	// Idle workers sleep on this until a job is queued
+	std::condition_variable jobCondition;
+	bool stopping = false;
+
+	/* ----- Finished reads, waiting for the GL thread ----- */
+	std::deque<Upload> uploads;
+	std::mutex uploadMutex;
+	std::atomic<size_t> numPending{ 0 };
+};
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "BlockCompressor.h"
+
+namespace {
+uint16_t PackRGB565(const uint8_t* color) {
+	return (uint16_t)((((color[0] * 31 + 127) / 255) << 11) |
+	                  (((color[1] * 63 + 127) / 255) << 5) |
+	                  ((color[2] * 31 + 127) / 255));
+}
+
+// Expand a 565 color back to 8 bits per channel, the same way the GPU decodes it
+void UnpackRGB565(const uint16_t packed, int* color) {
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+// Little-endian, since that's how the blocks are laid out
+void WriteUInt16(const uint16_t value, uint8_t* out) {
+	out[0] = (uint8_t)(value & 0xFF);
+	out[1] = (uint8_t)(value >> 8);
+}
+
+// Run a few rounds of power iteration on a 3x3 covariance matrix, starting from 'axis'.
+//   Returns the variance along the resulting axis (0 if the axis collapses to nothing)
+float PowerIterate(const float covariance[3][3], float* axis) {
+	for (int iteration = 0; iteration < 4; ++iteration) {
+		float next[3];
+		for (int row = 0; row < 3; ++row) {
+			next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] +
+			            covariance[row][2] * axis[2];
+		}
+		const float length = std::max(std::fabs(next[0]),
+		                              std::max(std::fabs(next[1]), std::fabs(next[2])));
+		if (length < FLT_EPSILON) {
+			break;
+		}
+		for (int c = 0; c < 3; ++c) {
+			axis[c] = next[c] / length;
+		}
+	}
+	const float length_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	if (length_sq < FLT_EPSILON) {
+		return 0.0f;
+	}
+	float variance = 0.0f;
+	for (int row = 0; row < 3; ++row) {
+		for (int col = 0; col < 3; ++col) {
+			variance += axis[row] * covariance[row][col] * axis[col];
+		}
+	}
+	return variance / length_sq;
+}
+} // namespace
+
+std::vector<std::vector<uint8_t> > BlockCompressor::CompressMipChain(const uint8_t* pixels,
+                                                                    const int width,
+                                                                    const int height,
+                                                                    const bool keep_alpha) {
+	std::vector<std::vector<uint8_t> > levels;
+	std::vector<uint8_t> level_pixels;
+	const uint8_t* source = pixels;
+	int level_width = width;
+	int level_height = height;
+	while (true) {
+		levels.push_back(CompressLevel(source, level_width, level_height, keep_alpha));
+		if (level_width == 1 && level_height == 1) {
+			break;
+		}
+		// Each level is filtered from the one above it, not from level 0
+		std::vector<uint8_t> next_pixels = Downsample(source, level_width, level_height);
+		level_pixels = std::move(next_pixels);
+		source = level_pixels.data();
+		level_width = std::max(level_width / 2, 1);
+		level_height = std::max(level_height / 2, 1);
+	}
+	return levels;
+}
+
+std::vector<uint8_t> BlockCompressor::CompressLevel(const uint8_t* pixels, const int width,
+                                                    const int height, const bool keep_alpha) {
+	const int blocks_x = (width + 3) / 4;
+	const int blocks_y = (height + 3) / 4;
+	const size_t block_size = keep_alpha ? 16 : 8;
+	std::vector<uint8_t> blocks((size_t)blocks_x * blocks_y * block_size);
+	uint8_t* out = blocks.data();
+	uint8_t block[16 * 4];
+	for (int block_y = 0; block_y < blocks_y; ++block_y) {
+		for (int block_x = 0; block_x < blocks_x; ++block_x) {
+			// Gather the block's pixels, row by row
+			for (int y = 0; y < 4; ++y) {
+				const int pixel_y = std::min(block_y * 4 + y, height - 1);
+				for (int x = 0; x < 4; ++x) {
+					const int pixel_x = std::min(block_x * 4 + x, width - 1);
+					memcpy(&block[(y * 4 + x) * 4],
+					       &pixels[((size_t)pixel_y * width + pixel_x) * 4], 4);
+				}
+			}
+			// BC3 blocks are the alpha block followed by a BC1 color block
+			if (keep_alpha) {
+				CompressAlphaBlock(block, out);
+				out += 8;
+			}
+			CompressColorBlock(block, out);
+			out += 8;
+		}
+	}
+	return blocks;
+}
+
+std::vector<uint8_t> BlockCompressor::Downsample(const uint8_t* pixels, const int width,
+                                                 const int height) {
+	const int new_width = std::max(width / 2, 1);
+	const int new_height = std::max(height / 2, 1);
+	std::vector<uint8_t> result((size_t)new_width * new_height * 4);
+	for (int y = 0; y < new_height; ++y) {
+		// For odd sizes, the last row & column are dropped, like the GPU would
+		const int y0 = std::min(y * 2, height - 1);
+		const int y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < new_width; ++x) {
+			const int x0 = std::min(x * 2, width - 1);
+			const int x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; ++c) {
+				const int sum = pixels[((size_t)y0 * width + x0) * 4 + c] +
+				                pixels[((size_t)y0 * width + x1) * 4 + c] +
+				                pixels[((size_t)y1 * width + x0) * 4 + c] +
+				                pixels[((size_t)y1 * width + x1) * 4 + c];
+				result[((size_t)y * new_width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+	return result;
+}
+
+void BlockCompressor::CompressColorBlock(const uint8_t* block, uint8_t* out) {
+	/* ----- Find the axis that the colors are spread along ----- */
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	int min_color[3] = { 255, 255, 255 };
+	int max_color[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			mean[c] += block[i * 4 + c] / 16.0f;
+			min_color[c] = std::min(min_color[c], (int)block[i * 4 + c]);
+			max_color[c] = std::max(max_color[c], (int)block[i * 4 + c]);
+		}
+	}
+	float covariance[3][3] = {};
+	for (int i = 0; i < 16; ++i) {
+		float offset[3];
+		for (int c = 0; c < 3; ++c) {
+			offset[c] = block[i * 4 + c] - mean[c];
+		}
+		for (int row = 0; row < 3; ++row) {
+			for (int col = 0; col < 3; ++col) {
+				covariance[row][col] += offset[row] * offset[col];
+			}
+		}
+	}
+	// Power iteration converges on the main axis unless its seed is orthogonal to it, and
+	//   any single cheap seed can be: a channel, or even the covariance column with the
+	//   largest norm, can be an eigenvector of a smaller axis. So iterate from two seeds and
+	//   keep whichever axis the colors vary along the most:
+	//   - the covariance column with the largest norm
+	//   - the bounding box diagonal, with each channel's sign taken from its covariance
+	//     with the channel that has the largest range
+	int largest_column = 0;
+	float largest_norm = -1.0f;
+	for (int col = 0; col < 3; ++col) {
+		const float norm = covariance[0][col] * covariance[0][col] +
+		                   covariance[1][col] * covariance[1][col] +
+		                   covariance[2][col] * covariance[2][col];
+		if (norm > largest_norm) {
+			largest_norm = norm;
+			largest_column = col;
+		}
+	}
+	float axis[3];
+	for (int c = 0; c < 3; ++c) {
+		axis[c] = covariance[c][largest_column];
+	}
+	const float axis_variance = PowerIterate(covariance, axis);
+
+	float range[3];
+	int widest_channel = 0;
+	for (int c = 0; c < 3; ++c) {
+		range[c] = (float)(max_color[c] - min_color[c]);
+		if (range[c] > range[widest_channel]) {
+			widest_channel = c;
+		}
+	}
+	float diagonal[3];
+	for (int c = 0; c < 3; ++c) {
+		diagonal[c] = (covariance[widest_channel][c] < 0.0f) ? -range[c] : range[c];
+	}
+	if (PowerIterate(covariance, diagonal) > axis_variance) {
+		std::copy(diagonal, diagonal + 3, axis);
+	}
+
+	/* ----- Use the two pixels furthest along the axis as endpoints ----- */
+	int min_pixel = 0;
+	int max_pixel = 0;
+	float min_dot = FLT_MAX;
+	float max_dot = -FLT_MAX;
+	for (int i = 0; i < 16; ++i) {
+		const float dot = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1] +
+		                  block[i * 4 + 2] * axis[2];
+		if (dot < min_dot) {
+			min_dot = dot;
+			min_pixel = i;
+		}
+		if (dot > max_dot) {
+			max_dot = dot;
+			max_pixel = i;
+		}
+	}
+	uint16_t endpoint0 = PackRGB565(&block[max_pixel * 4]);
+	uint16_t endpoint1 = PackRGB565(&block[min_pixel * 4]);
+	// endpoint0 > endpoint1 selects the 4-color palette. The indices are picked afterward,
+	//   so swapping the endpoints doesn't need any fixing up
+	if (endpoint0 < endpoint1) {
+		std::swap(endpoint0, endpoint1);
+	}
+	WriteUInt16(endpoint0, out);
+	WriteUInt16(endpoint1, out + 2);
+
+	/* ----- Pick the closest palette entry for each pixel ----- */
+	uint32_t indices = 0;
+	// With equal endpoints, every entry is the same, so index 0 is as good as any
+	if (endpoint0 != endpoint1) {
+		int palette[4][3];
+		UnpackRGB565(endpoint0, palette[0]);
+		UnpackRGB565(endpoint1, palette[1]);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; ++i) {
+			int best_index = 0;
+			int best_distance = INT32_MAX;
+			for (int entry = 0; entry < 4; ++entry) {
+				int distance = 0;
+				for (int c = 0; c < 3; ++c) {
+					const int diff = block[i * 4 + c] - palette[entry][c];
+					distance += diff * diff;
+				}
+				if (distance < best_distance) {
+					best_distance = distance;
+					best_index = entry;
+				}
+			}
+			indices |= (uint32_t)best_index << (i * 2);
+		}
+	}
+	for (int byte = 0; byte < 4; ++byte) {
+		out[4 + byte] = (uint8_t)((indices >> (byte * 8)) & 0xFF);
+	}
+}
+
+void BlockCompressor::CompressAlphaBlock(const uint8_t* block, uint8_t* out) {
+	int min_alpha = 255;
+	int max_alpha = 0;
+	for (int i = 0; i < 16; ++i) {
+		min_alpha = std::min(min_alpha, (int)block[i * 4 + 3]);
+		max_alpha = std::max(max_alpha, (int)block[i * 4 + 3]);
+	}
+	// alpha0 > alpha1 selects the palette with 6 interpolated values
+	out[0] = (uint8_t)max_alpha;
+	out[1] = (uint8_t)min_alpha;
+
+	uint64_t indices = 0;
+	if (max_alpha != min_alpha) {
+		int palette[8];
+		palette[0] = max_alpha;
+		palette[1] = min_alpha;
+		for (int step = 1; step < 7; ++step) {
+			palette[step + 1] = ((7 - step) * max_alpha + step * min_alpha) / 7;
+		}
+		for (int i = 0; i < 16; ++i) {
+			int best_index = 0;
+			int best_distance = INT32_MAX;
+			for (int entry = 0; entry < 8; ++entry) {
+				const int distance = std::abs(block[i * 4 + 3] - palette[entry]);
+				if (distance < best_distance) {
+					best_distance = distance;
+					best_index = entry;
+				}
+			}
+			indices |= (uint64_t)best_index << (i * 3);
+		}
+	}
+	for (int byte = 0; byte < 6; ++byte) {
+		out[2 + byte] = (uint8_t)((indices >> (byte * 8)) & 0xFF);
+	}
+}
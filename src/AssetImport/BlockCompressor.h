@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///
+/// Encodes RGBA8 images into BC1 (DXT1) or BC3 (DXT5) blocks, for baking textures into
+/// KTXFiles. Each 4x4 block's endpoints are the two pixels furthest apart along the
+/// block's main color axis, which is fast and good enough for diffuse & specular maps
+/// (BC7 files have to come from an external tool).
+///
+class BlockCompressor {
+public:
+	// Downsample 'pixels' (RGBA8, width x height) into a full mip chain, then compress
+	//   every level, level 0 first. BC3 keeps the alpha channel, and BC1 drops it
+	static std::vector<std::vector<uint8_t> > CompressMipChain(const uint8_t* pixels,
+	                                                          const int width,
+	                                                          const int height,
+	                                                          const bool keep_alpha);
+
+private:
+	// Compress one level. Blocks past the edge of the image repeat its last row & column
+	static std::vector<uint8_t> CompressLevel(const uint8_t* pixels, const int width,
+	                                          const int height, const bool keep_alpha);
+	// Halve an image with a 2x2 box filter (or keep a dimension that's already 1)
+	static std::vector<uint8_t> Downsample(const uint8_t* pixels, const int width,
+	                                       const int height);
+	// Encode the colors of 16 RGBA8 pixels into 8 bytes: two RGB565 endpoints, then a
+	//   2-bit palette index per pixel
+	static void CompressColorBlock(const uint8_t* block, uint8_t* out);
+	// Encode the alpha of 16 RGBA8 pixels into 8 bytes: two 8-bit endpoints, then a 3-bit
+	//   palette index per pixel
+	static void CompressAlphaBlock(const uint8_t* block, uint8_t* out);
+};
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "KTXFile.h"
+
+std::vector<GLenum> KTXFile::supportedFormats;
+
+namespace {
+const uint8_t KTX_IDENTIFIER[12] = {
+	0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+// Written as-is, so files from a machine with the other byte order are rejected
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+// Key holding the source image's size & modification time, as a uint64 and an int64
+const char SOURCE_KEY[] = "SpiderGame.source";
+const char ORIENTATION_KEY[] = "KTXorientation";
+const char ORIENTATION_VALUE[] = "S=r,T=u";
+
+bool IsKnownFormat(const GLenum internal_format) {
+	return internal_format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+	       internal_format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ||
+	       internal_format == GL_COMPRESSED_RGBA_BPTC_UNORM;
+}
+} // namespace
+
+bool KTXFile::Load(const std::string& path, const std::string& source_path) {
+	Close();
+	if (!file.Open(path)) {
+		return false;
+	}
+	/* ----- Check that the file holds a single compressed 2D texture ----- */
+	Header header;
+	if (file.GetSize() < sizeof(Header)) {
+		Close();
+		return false;
+	}
+	memcpy(&header, file.GetData(), sizeof(Header));
+	if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 ||
+	    header.endianness != KTX_ENDIANNESS || header.glType != 0 ||
+	    !IsKnownFormat(header.glInternalFormat) || header.pixelWidth == 0 ||
+	    header.pixelHeight == 0 || header.pixelDepth != 0 ||
+	    header.numberOfArrayElements != 0 || header.numberOfFaces != 1) {
+		std::cout << "WARNING: " << path << " isn't a BC1, BC3 or BC7 2D texture, so";
+		std::cout << " it will be ignored" << std::endl;
+		Close();
+		return false;
+	}
+	size_t offset = sizeof(Header);
+	const size_t key_value_end = offset + header.bytesOfKeyValueData;
+	if (key_value_end > file.GetSize() || !IsUpToDate(offset, key_value_end, source_path)) {
+		Close();
+		return false;
+	}
+	offset = key_value_end;
+
+	/* ----- Point each level at its blocks in the mapping ----- */
+	internalFormat = header.glInternalFormat;
+	// 0 levels means the mips should be generated, but there's only ever level 0 then
+	const uint32_t num_levels = std::max(header.numberOfMipmapLevels, 1u);
+	GLsizei width = (GLsizei)header.pixelWidth;
+	GLsizei height = (GLsizei)header.pixelHeight;
+	for (uint32_t i = 0; i < num_levels; ++i) {
+		if (offset + sizeof(uint32_t) > file.GetSize()) {
+			break;
+		}
+		const uint32_t image_size = ReadUInt32(offset);
+		offset += sizeof(uint32_t);
+		// The size is fixed by the format, so anything else means the file is damaged
+		if (image_size != GetLevelSize(internalFormat, width, height) ||
+		    image_size > file.GetSize() - offset) {
+			break;
+		}
+		MipLevel level;
+		level.data = file.GetData() + offset;
+		level.numBytes = (GLsizei)image_size;
+		level.width = width;
+		level.height = height;
+		levels.push_back(level);
+		offset += Align(image_size);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	if (levels.size() != num_levels) {
+		std::cerr << "ERROR: Compressed texture " << path << " is damaged, so the image";
+		std::cerr << " will be loaded instead" << std::endl;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void KTXFile::Close() {
+	file.Close();
+	internalFormat = 0;
+	levels.clear();
+}
+
+bool KTXFile::Write(const std::string& path, const std::string& source_path,
+                    const GLenum internal_format, const GLsizei width, const GLsizei height,
+                    const std::vector<std::vector<uint8_t> >& levels) {
+	/* ----- Build the key/value pairs ----- */
+	// Each pair is its size, then "key\0value", padded to a 4-byte boundary
+	std::vector<uint8_t> key_values;
+	auto add_key_value = [&key_values](const char* key, const void* value,
+	                                   const size_t value_size) {
+		const size_t key_size = strlen(key) + 1;
+		const uint32_t pair_size = (uint32_t)(key_size + value_size);
+		const size_t start = key_values.size();
+		key_values.resize(start + sizeof(uint32_t) + Align(pair_size), 0);
+		memcpy(&key_values[start], &pair_size, sizeof(uint32_t));
+		memcpy(&key_values[start + sizeof(uint32_t)], key, key_size);
+		memcpy(&key_values[start + sizeof(uint32_t) + key_size], value, value_size);
+	};
+	uint64_t source_size;
+	int64_t source_mod_time;
+	if (!MappedFile::GetFileInfo(source_path, source_size, source_mod_time)) {
+		return false;
+	}
+	uint8_t source_info[sizeof(uint64_t) + sizeof(int64_t)];
+	memcpy(source_info, &source_size, sizeof(uint64_t));
+	memcpy(source_info + sizeof(uint64_t), &source_mod_time, sizeof(int64_t));
+	add_key_value(SOURCE_KEY, source_info, sizeof(source_info));
+	add_key_value(ORIENTATION_KEY, ORIENTATION_VALUE, sizeof(ORIENTATION_VALUE));
+
+	Header header = {};
+	memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+	header.endianness = KTX_ENDIANNESS;
+	// Compressed textures have no type or format, and a type size of 1
+	header.glTypeSize = 1;
+	header.glInternalFormat = internal_format;
+	header.glBaseInternalFormat =
+		(internal_format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? GL_RGB : GL_RGBA;
+	header.pixelWidth = (uint32_t)width;
+	header.pixelHeight = (uint32_t)height;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = (uint32_t)levels.size();
+	header.bytesOfKeyValueData = (uint32_t)key_values.size();
+
+	/* ----- Write the header, then each level's size and blocks ----- */
+	// Write to a temporary file first, then move it into place. Truncating the real file
+	//   would pull it out from under any loader that has it mapped
+	const std::string temp_path = path + ".tmp";
+	std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "ERROR: Could not write compressed texture " << path << std::endl;
+		return false;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)key_values.data(), key_values.size());
+	for (const std::vector<uint8_t>& level : levels) {
+		static const char padding[4] = { 0, 0, 0, 0 };
+		const uint32_t image_size = (uint32_t)level.size();
+		out.write((const char*)&image_size, sizeof(image_size));
+		out.write((const char*)level.data(), level.size());
+		out.write(padding, Align(level.size()) - level.size());
+	}
+	out.close();
+	if (!out) {
+		std::cerr << "ERROR: Could not write compressed texture " << path << std::endl;
+		remove(temp_path.c_str());
+		return false;
+	}
+	if (!MappedFile::MoveIntoPlace(temp_path, path)) {
+		std::cerr << "ERROR: Could not replace compressed texture " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string KTXFile::GetCachePath(const std::string& image_path) {
+	return image_path + ".ktx";
+}
+
+size_t KTXFile::GetLevelSize(const GLenum internal_format, const GLsizei width,
+                             const GLsizei height) {
+	// BC1 packs each block into 8 bytes, and the others use 16
+	const size_t block_size = (internal_format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? 8 : 16;
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * block_size;
+}
+
+void KTXFile::QuerySupportedFormats() {
+	supportedFormats.clear();
+	const GLenum formats[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+	                           GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	                           GL_COMPRESSED_RGBA_BPTC_UNORM };
+#ifdef GL_VERSION_4_3
+	if (GLAD_GL_VERSION_4_3) {
+		for (const GLenum format : formats) {
+			GLint is_supported = GL_FALSE;
+			glGetInternalformativ(GL_TEXTURE_2D, format, GL_INTERNALFORMAT_SUPPORTED, 1,
+			                      &is_supported);
+			if (is_supported == GL_TRUE) {
+				supportedFormats.push_back(format);
+			}
+		}
+	}
+	else
+#endif
+	{
+		// Older contexts can only list the compressed formats they support
+		GLint num_formats = 0;
+		glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &num_formats);
+		std::vector<GLint> listed_formats(std::max(num_formats, 0));
+		if (!listed_formats.empty()) {
+			glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, listed_formats.data());
+		}
+		for (const GLenum format : formats) {
+			if (std::find(listed_formats.begin(), listed_formats.end(), (GLint)format) !=
+			    listed_formats.end()) {
+				supportedFormats.push_back(format);
+			}
+		}
+	}
+	if (supportedFormats.empty()) {
+		std::cout << "WARNING: No BC texture compression support, so textures will be";
+		std::cout << " uploaded uncompressed" << std::endl;
+	}
+}
+
+bool KTXFile::IsFormatSupported(const GLenum internal_format) {
+	return std::find(supportedFormats.begin(), supportedFormats.end(), internal_format) !=
+	       supportedFormats.end();
+}
+
+size_t KTXFile::GetNumBytes() const {
+	size_t num_bytes = 0;
+	for (const MipLevel& level : levels) {
+		num_bytes += level.numBytes;
+	}
+	return num_bytes;
+}
+
+bool KTXFile::IsUpToDate(size_t offset, const size_t end,
+                         const std::string& source_path) const {
+	while (offset + sizeof(uint32_t) <= end) {
+		const uint32_t pair_size = ReadUInt32(offset);
+		offset += sizeof(uint32_t);
+		if (pair_size > end - offset) {
+			return false;
+		}
+		const char* pair = (const char*)file.GetData() + offset;
+		const size_t key_length = strnlen(pair, pair_size);
+		const char* value = pair + key_length + 1;
+		const size_t value_size = pair_size - std::min<size_t>(key_length + 1, pair_size);
+		if (key_length == strlen(SOURCE_KEY) && memcmp(pair, SOURCE_KEY, key_length) == 0 &&
+		    value_size == sizeof(uint64_t) + sizeof(int64_t)) {
+			uint64_t baked_size;
+			int64_t baked_mod_time;
+			memcpy(&baked_size, value, sizeof(uint64_t));
+			memcpy(&baked_mod_time, value + sizeof(uint64_t), sizeof(int64_t));
+			uint64_t source_size;
+			int64_t source_mod_time;
+			// If the source image is gone, the baked file is all that's left
+			if (!MappedFile::GetFileInfo(source_path, source_size, source_mod_time)) {
+				return true;
+			}
+			return baked_size == source_size && baked_mod_time == source_mod_time;
+		}
+		offset += Align(pair_size);
+	}
+	// Made by another tool, so there's nothing to compare against
+	return true;
+}
+
+uint32_t KTXFile::ReadUInt32(const size_t offset) const {
+	uint32_t value;
+	memcpy(&value, file.GetData() + offset, sizeof(uint32_t));
+	return value;
+}
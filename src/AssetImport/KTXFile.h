@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../Utils/MappedFile.h"
+
+// S3TC is an extension, so the GL loader may not define its formats
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+///
+/// A block-compressed 2D texture with its whole mip chain, stored as a KTX 1.1 file. Only
+/// BC1 (DXT1), BC3 (DXT5) and BC7 (BPTC) textures are supported. Each level's blocks are
+/// uploaded straight from the mapped file with glCompressedTexImage2D, so nothing is
+/// decoded or copied on the CPU.
+///
+/// Texture bakes an image into "<image file>.ktx" the first time it's loaded (see
+/// BlockCompressor). Baked files record the source image's size & modification time, and
+/// are rebuilt when it changes. Files made by other tools (i.e. to use BC7) are used as-is,
+/// but must store the bottom row first, as OpenGL expects (KTXorientation "S=r,T=u").
+///
+class KTXFile {
+public:
+	struct MipLevel {
+		const uint8_t* data = nullptr;
+		GLsizei numBytes = 0;
+		GLsizei width = 0;
+		GLsizei height = 0;
+	};
+
+	KTXFile() = default;
+	~KTXFile() = default;
+
+	// Map a KTX file. Returns false if it's missing, damaged, or not a compressed 2D
+	//   texture in a supported format, or if it was baked from an older 'source_path'
+	bool Load(const std::string& path, const std::string& source_path);
+	void Close();
+	// Write a KTX file holding 'levels' (level 0 first), baked from 'source_path'. Returns
+	//   false if it couldn't be written
+	static bool Write(const std::string& path, const std::string& source_path,
+	                  const GLenum internal_format, const GLsizei width, const GLsizei height,
+	                  const std::vector<std::vector<uint8_t> >& levels);
+	static std::string GetCachePath(const std::string& image_path);
+
+	// Size of one compressed level. Every supported format uses 4x4 blocks
+	static size_t GetLevelSize(const GLenum internal_format, const GLsizei width,
+	                           const GLsizei height);
+	// Find which compressed formats the GPU can sample. Must be called on the GL thread,
+	//   before any textures are loaded
+	static void QuerySupportedFormats();
+	static bool IsFormatSupported(const GLenum internal_format);
+
+	/* ----- Getters ----- */
+	bool IsLoaded() const { return file.IsOpen(); }
+	GLenum GetInternalFormat() const { return internalFormat; }
+	const std::vector<MipLevel>& GetLevels() const { return levels; }
+	// Total size of every level
+	size_t GetNumBytes() const;
+
+private:
+	struct Header {
+		uint8_t identifier[12];
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+	// Check the key/value pairs for the source image's size & modification time. Returns
+	//   false if they don't match the source image anymore
+	bool IsUpToDate(size_t offset, const size_t end, const std::string& source_path) const;
+	// Read a 32-bit value from the mapped file, which may not be aligned
+	uint32_t ReadUInt32(const size_t offset) const;
+	// Round up to the next multiple of 4
+	static size_t Align(const size_t num_bytes) { return (num_bytes + 3) & ~(size_t)3; }
+
+	// Formats that QuerySupportedFormats found
+	static std::vector<GLenum> supportedFormats;
+
+	MappedFile file;
+	GLenum internalFormat = 0;
+	std::vector<MipLevel> levels;
+};
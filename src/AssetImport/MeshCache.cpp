@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "MeshCache.h"
+
+constexpr uint32_t MeshCache::VERSION;
+
+namespace {
+const char CACHE_MAGIC[4] = { 'S', 'G', 'M', 'C' };
+} // namespace
+
+bool MeshCache::Load(const std::string& model_path, const VertexFormat vertex_format) {
+	const size_t vertex_size = MeshArena::GetVertexSize(vertex_format);
+	meshes.clear();
+	readOffset = 0;
+	uint64_t source_size;
+	int64_t source_mod_time;
+	if (!MappedFile::GetFileInfo(model_path, source_size, source_mod_time) ||
+	    !file.Open(GetCachePath(model_path))) {
+		return false;
+	}
+
+	/* ----- Check that the cache matches the model file & this version ----- */
+	const FileHeader* header = (const FileHeader*)Take(sizeof(FileHeader));
+	if (!header || memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+	    header->version != VERSION || header->vertexFormat != (uint32_t)vertex_format ||
+	    header->vertexSize != vertex_size ||
+	    header->sourceSize != source_size || header->sourceModTime != source_mod_time) {
+		file.Close();
+		return false;
+	}
+	const float* min = header->boundsMin;
+	const float* max = header->boundsMax;
+	const float* center = header->sphereCenter;
+	bounds = AABB(glm::vec3(min[0], min[1], min[2]), glm::vec3(max[0], max[1], max[2]));
+	boundingSphere = BoundingSphere(glm::vec3(center[0], center[1], center[2]),
+	                                header->sphereRadius);
+
+	/* ----- Point each mesh at its data in the mapping ----- */
+	// Every mesh takes at least its header, so a count that couldn't fit in the rest of
+	//   the file is damaged. Checked before resizing, so a bad count can't allocate much
+	bool is_valid = (uint64_t)header->numMeshes * sizeof(MeshHeader) <=
+	                file.GetSize() - readOffset;
+	if (is_valid) {
+		meshes.resize(header->numMeshes);
+		for (MeshView& mesh : meshes) {
+			if (!ReadMesh(mesh, vertex_size)) {
+				is_valid = false;
+				break;
+			}
+		}
+	}
+	// A cache that was cut short (i.e. a crash while writing it) reads past the end
+	if (!is_valid || readOffset != file.GetSize()) {
+		std::cerr << "ERROR: Mesh cache for " << model_path << " is damaged, so the model";
+		std::cerr << " will be imported again" << std::endl;
+		meshes.clear();
+		file.Close();
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::Write(const std::string& model_path, const VertexFormat vertex_format,
+                      const std::vector<MeshView>& meshes, const AABB& bounds,
+                      const BoundingSphere& bounding_sphere) {
+	const size_t vertex_size = MeshArena::GetVertexSize(vertex_format);
+	FileHeader header = {};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = VERSION;
+	header.vertexFormat = (uint32_t)vertex_format;
+	header.vertexSize = (uint32_t)vertex_size;
+	header.numMeshes = (uint32_t)meshes.size();
+	if (!MappedFile::GetFileInfo(model_path, header.sourceSize, header.sourceModTime)) {
+		return false;
+	}
+	for (int i = 0; i < 3; ++i) {
+		header.boundsMin[i] = bounds.min[i];
+		header.boundsMax[i] = bounds.max[i];
+		header.sphereCenter[i] = bounding_sphere.center[i];
+	}
+	header.sphereRadius = bounding_sphere.radius;
+
+	const std::string cache_path = GetCachePath(model_path);
+	// Write to a temporary file first, then move it into place. Truncating the real file
+	//   would pull it out from under any loader that has it mapped
+	const std::string temp_path = cache_path + ".tmp";
+	std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "ERROR: Could not write mesh cache " << cache_path << std::endl;
+		return false;
+	}
+	// Write a block, then pad it to the next 4-byte boundary
+	auto write_aligned = [&out](const void* data, const size_t num_bytes) {
+		static const char padding[4] = { 0, 0, 0, 0 };
+		out.write((const char*)data, num_bytes);
+		out.write(padding, Align(num_bytes) - num_bytes);
+	};
+	write_aligned(&header, sizeof(header));
+	for (const MeshView& mesh : meshes) {
+		MeshHeader mesh_header;
+		mesh_header.numVertices = mesh.numVertices;
+		mesh_header.numIndices = mesh.numIndices;
+		mesh_header.numTextures = (uint32_t)mesh.textures.size();
+		write_aligned(&mesh_header, sizeof(mesh_header));
+		for (const TextureRef& texture : mesh.textures) {
+			TextureHeader tex_header;
+			tex_header.type = (uint32_t)texture.type;
+			tex_header.pathLength = (uint32_t)texture.path.size();
+			write_aligned(&tex_header, sizeof(tex_header));
+			write_aligned(texture.path.data(), texture.path.size());
+		}
+		write_aligned(mesh.vertices, (size_t)mesh.numVertices * vertex_size);
+		write_aligned(mesh.indices, (size_t)mesh.numIndices * sizeof(GLuint));
+	}
+	out.close();
+	if (!out) {
+		std::cerr << "ERROR: Could not write mesh cache " << cache_path << std::endl;
+		remove(temp_path.c_str());
+		return false;
+	}
+	if (!MappedFile::MoveIntoPlace(temp_path, cache_path)) {
+		std::cerr << "ERROR: Could not replace mesh cache " << cache_path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string& model_path) {
+	return model_path + ".meshcache";
+}
+
+bool MeshCache::ReadMesh(MeshView& mesh, const size_t vertex_size) {
+	const MeshHeader* mesh_header = (const MeshHeader*)Take(sizeof(MeshHeader));
+	if (!mesh_header) {
+		return false;
+	}
+	constexpr uint32_t num_tex_types = (uint32_t)Texture::TextureType::ENUM_END;
+	for (uint32_t i = 0; i < mesh_header->numTextures; ++i) {
+		const TextureHeader* tex_header = (const TextureHeader*)Take(sizeof(TextureHeader));
+		if (!tex_header || tex_header->type >= num_tex_types) {
+			return false;
+		}
+		const char* path = (const char*)Take(tex_header->pathLength);
+		if (!path) {
+			return false;
+		}
+		mesh.textures.push_back(TextureRef{ (Texture::TextureType)tex_header->type,
+		                                    std::string(path, tex_header->pathLength) });
+	}
+	mesh.numVertices = mesh_header->numVertices;
+	mesh.numIndices = mesh_header->numIndices;
+	mesh.vertices = Take((size_t)mesh.numVertices * vertex_size);
+	mesh.indices = (const GLuint*)Take((size_t)mesh.numIndices * sizeof(GLuint));
+	if (!mesh.vertices || !mesh.indices) {
+		return false;
+	}
+	// Indices are relative to the mesh's first vertex, and one past the end would make the
+	//   GPU read another mesh's vertices (or past the end of the arena)
+	for (GLuint i = 0; i < mesh.numIndices; ++i) {
+		if (mesh.indices[i] >= mesh.numVertices) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const uint8_t* MeshCache::Take(const size_t num_bytes) {
+	if (readOffset > file.GetSize() || num_bytes > file.GetSize() - readOffset) {
+		// Put the offset past the end, so every later read and the size check at the end
+		//   of Load fail too
+		readOffset = file.GetSize() + 1;
+		return nullptr;
+	}
+	const uint8_t* data = file.GetData() + readOffset;
+	readOffset = std::min(readOffset + Align(num_bytes), file.GetSize());
+	return data;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "StaticMesh.h"
+#include "Texture.h"
+#include "../Utils/Bounds.h"
+#include "../Utils/MappedFile.h"
+
+///
+/// Binary cache of a Model's processed meshes, stored next to the model file as
+/// "<model file>.meshcache". The first time a model is loaded, Assimp's output is baked
+/// into a cache, and later loads map the cache instead of running Assimp. Vertex & index
+/// data are stored exactly as the GPU expects them, so they're uploaded straight from the
+/// mapping without being copied or converted.
+///
+/// Layout (every section starts on a 4-byte boundary):
+///   FileHeader
+///   For each mesh:
+///     MeshHeader
+///     For each texture: TextureHeader, then the path (not null-terminated)
+///     Vertex or PackedVertex[numVertices], then GLuint[numIndices]
+///
+/// A cache is rebuilt when the model file's size or modification time changes, or when
+/// the format (including the vertex format & layout) changes.
+///
+class MeshCache {
+public:
+	// Texture used by a mesh. Stored by path, so it can be loaded through the Scene
+	struct TextureRef {
+		Texture::TextureType type;
+		std::string path;
+	};
+	// A single mesh's data. For a loaded cache, the vertex & index pointers point into the
+	//   mapped file, so they're only valid while the MeshCache exists
+	struct MeshView {
+		// In the VertexFormat that the cache was loaded or written with
+		const void* vertices = nullptr;
+		GLuint numVertices = 0;
+		const GLuint* indices = nullptr;
+		GLuint numIndices = 0;
+		std::vector<TextureRef> textures;
+	};
+
+	MeshCache() = default;
+	~MeshCache() = default;
+
+	// Map the cache for a model file. Returns false if there's no cache, or if it's out of
+	//   date, damaged, or holds another vertex format, in which case the model should be
+	//   imported again
+	bool Load(const std::string& model_path, const VertexFormat vertex_format);
+	// Bake a model's meshes into its cache file. Returns false if it couldn't be written
+	static bool Write(const std::string& model_path, const VertexFormat vertex_format,
+	                  const std::vector<MeshView>& meshes, const AABB& bounds,
+	                  const BoundingSphere& bounding_sphere);
+	static std::string GetCachePath(const std::string& model_path);
+
+	/* ----- Getters ----- */
+	const std::vector<MeshView>& GetMeshes() const { return meshes; }
+	const AABB& GetBounds() const { return bounds; }
+	const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
+
+private:
+	// Bump whenever the layout changes, so that old caches are rebuilt
+	static constexpr uint32_t VERSION = 2;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		// VertexFormat of the stored vertices, and their size when the cache was written
+		uint32_t vertexFormat;
+		uint32_t vertexSize;
+		uint32_t numMeshes;
+		// Size & modification time of the model file that was baked
+		uint64_t sourceSize;
+		int64_t sourceModTime;
+		float boundsMin[3];
+		float boundsMax[3];
+		float sphereCenter[3];
+		float sphereRadius;
+	};
+	struct MeshHeader {
+		uint32_t numVertices;
+		uint32_t numIndices;
+		uint32_t numTextures;
+	};
+	struct TextureHeader {
+		uint32_t type;
+		uint32_t pathLength;
+	};
+
+	// Read one mesh's header, textures, vertices & indices. Returns false if any of its
+	//   counts run past the end of the file, or it has an invalid texture type or index
+	bool ReadMesh(MeshView& mesh, const size_t vertex_size);
+	// Claim the next num_bytes of the mapped file, then skip ahead to a 4-byte boundary.
+	//   Returns nullptr if the file is too short
+	const uint8_t* Take(const size_t num_bytes);
+	// Round up to the next multiple of 4
+	static size_t Align(const size_t num_bytes) { return (num_bytes + 3) & ~(size_t)3; }
+
+	MappedFile file;
+	// Read position in the mapped file, while loading
+	size_t readOffset = 0;
+	std::vector<MeshView> meshes;
+	AABB bounds;
+	BoundingSphere boundingSphere;
+};
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -6,12 +7,91 @@
 #include <assimp/postprocess.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "../Rendering/Scene.h"
 #include "Model.h"
 #include "Texture.h"
 
-Model::Model(const std::string& filename, std::weak_ptr<Scene> scene_ref) {
+std::unique_ptr<Model::ModelData> Model::ReadFile(const std::string& filename,
+                                                  const VertexFormat vertex_format) {
+	auto data = std::make_unique<ModelData>();
+	data->vertexFormat = vertex_format;
+	// The cache's vertex & index data stays in the mapped file until it's uploaded, then
+	//   the mapping is closed when the data is destroyed
+	if (data->cache.Load(filename, vertex_format)) {
+		data->meshes = data->cache.GetMeshes();
+		data->bounds = data->cache.GetBounds();
+		data->boundingSphere = data->cache.GetBoundingSphere();
+		return data;
+	}
+	ImportFromFile(filename, vertex_format, *data);
+	return data;
+}
+
+size_t Model::ModelData::GetNumBytes() const {
+	size_t num_bytes = 0;
+	for (const MeshCache::MeshView& mesh : meshes) {
+		num_bytes += (size_t)mesh.numVertices * MeshArena::GetVertexSize(vertexFormat);
+		num_bytes += (size_t)mesh.numIndices * sizeof(GLuint);
+	}
+	return num_bytes;
+}
+
+Model::Model(const std::string& filename, std::weak_ptr<Scene> scene_ref,
+             const std::shared_ptr<MeshArena>& mesh_arena) :
+	meshArena(mesh_arena) {
+	Upload(*ReadFile(filename, GetVertexFormat()), scene_ref);
+}
+
+Model::Model(const std::shared_ptr<MeshArena>& mesh_arena) :
+	meshArena(mesh_arena) {}
+
+void Model::Upload(const ModelData& data, std::weak_ptr<Scene> scene_ref) {
+	for (const MeshCache::MeshView& mesh : data.meshes) {
+		AddMesh(mesh, scene_ref);
+	}
+	bounds = data.bounds;
+	boundingSphere = data.boundingSphere;
+	// Packed positions are [0, 1] across the bounds, so scale them back up
+	if (data.vertexFormat == VertexFormat::PACKED && bounds.IsValid()) {
+		vertexTransform = glm::translate(glm::mat4(1.0f), bounds.min);
+		vertexTransform = glm::scale(vertexTransform, bounds.max - bounds.min);
+	}
+	numBytes = data.GetNumBytes();
+	loaded = true;
+}
+
+bool Model::IsLoaded() const {
+	return loaded;
+}
+
+size_t Model::GetNumBytes() const {
+	return numBytes;
+}
+
+const std::vector<std::shared_ptr<StaticMesh> >& Model::GetMeshes() const {
+	return meshList;
+}
+
+const AABB& Model::GetBounds() const {
+	return bounds;
+}
+
+const BoundingSphere& Model::GetBoundingSphere() const {
+	return boundingSphere;
+}
+
+const glm::mat4& Model::GetVertexTransform() const {
+	return vertexTransform;
+}
+
+VertexFormat Model::GetVertexFormat() const {
+	return meshArena->GetVertexFormat();
+}
+
+void Model::ImportFromFile(const std::string& filename, const VertexFormat vertex_format,
+                           ModelData& data) {
 	Assimp::Importer importer;
 	// Load the model's file into an Assimp scene (different than the Scene class)
 	// Read the file with some aiPostProcessSteps flags (see assimp->postprocess.h)
@@ -26,40 +106,61 @@ Model::Model(const std::string& filename, std::weak_ptr<Scene> scene_ref) {
 		std::cout << importer.GetErrorString() << std::endl;
 		return;
 	}
-	modelDir = filename.substr(0, filename.find_last_of('/'));
-	// Iterate through the scene and load the meshes & textures
-	ProcessNode(ai_scene->mRootNode, ai_scene, scene_ref);
-}
+	// Iterate through the scene and read the meshes & texture paths
+	const std::string model_dir = filename.substr(0, filename.find_last_of('/'));
+	ProcessNode(ai_scene->mRootNode, ai_scene, model_dir, data);
 
-void Model::Render(const std::shared_ptr<ShaderProgram>& shader,
-                   const std::weak_ptr<Texture> tex_override) const {
-	for (auto& mesh : meshList) {
-		mesh->Render(shader, tex_override);
+	/* ----- Bake the meshes ----- */
+	data.meshes.resize(data.importedMeshes.size());
+	for (size_t i = 0; i < data.importedMeshes.size(); ++i) {
+		ImportedMesh& imported_mesh = data.importedMeshes[i];
+		MeshCache::MeshView& mesh_view = data.meshes[i];
+		mesh_view.numVertices = (GLuint)imported_mesh.vertices.size();
+		if (vertex_format == VertexFormat::PACKED) {
+			// The model's bounds are only known once every mesh has been read
+			imported_mesh.packedVertices.reserve(imported_mesh.vertices.size());
+			for (const Vertex& vertex : imported_mesh.vertices) {
+				imported_mesh.packedVertices.emplace_back(vertex, data.bounds);
+			}
+			std::vector<Vertex>().swap(imported_mesh.vertices);
+			mesh_view.vertices = imported_mesh.packedVertices.data();
+		}
+		else {
+			mesh_view.vertices = imported_mesh.vertices.data();
+		}
+		mesh_view.indices = imported_mesh.indices.data();
+		mesh_view.numIndices = (GLuint)imported_mesh.indices.size();
+		mesh_view.textures = imported_mesh.textures;
 	}
+	// A failed write only means the next load has to import the file again
+	MeshCache::Write(filename, vertex_format, data.meshes, data.bounds, data.boundingSphere);
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene,
-	std::weak_ptr<Scene> scene_ref) {
+void Model::ProcessNode(aiNode* node, const aiScene* scene, const std::string& model_dir,
+                        ModelData& data) {
 	// Assimp scenes have a heirarchy of nodes, and each node can have multiple meshes
 	// Get the meshes attached to this node
 	for (size_t i = 0; i < node->mNumMeshes; ++i) {
 		aiMesh* new_mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessMesh(new_mesh, scene, scene_ref);
+		ProcessMesh(new_mesh, scene, model_dir, data);
 	}
 	// Process the child nodes recursively
 	for (size_t i = 0; i < node->mNumChildren; ++i) {
-		ProcessNode(node->mChildren[i], scene, scene_ref);
+		ProcessNode(node->mChildren[i], scene, model_dir, data);
 	}
 	// Note: Assimp can read nodes/meshes in parent-child relationships, but our model
 	//   class doesn't store these relationships. If an assimp scene is read that has
 	//   parents & children, the Model class will need to be updated to account for them
 }
 
-void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene,
-	std::weak_ptr<Scene> scene_ref) {
-	std::vector<Vertex> vertices;
-	std::vector<GLuint> indices;
-	std::vector<std::weak_ptr<Texture> > textures;
+void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene, const std::string& model_dir,
+                        ModelData& data) {
+	data.importedMeshes.emplace_back();
+	std::vector<Vertex>& vertices = data.importedMeshes.back().vertices;
+	std::vector<GLuint>& indices = data.importedMeshes.back().indices;
+	std::vector<MeshCache::TextureRef>& textures = data.importedMeshes.back().textures;
+	AABB mesh_bounds;
+	vertices.reserve(mesh->mNumVertices);
 
 	/* ----- Process vertices ----- */
 	for (size_t i = 0; i < mesh->mNumVertices; ++i) {
@@ -68,6 +169,7 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene,
 		new_vertex.position.x = mesh->mVertices[i].x;
 		new_vertex.position.y = mesh->mVertices[i].y;
 		new_vertex.position.z = mesh->mVertices[i].z;
+		mesh_bounds.Expand(new_vertex.position);
 		// Normals
 		if (mesh->HasNormals()) {
 			new_vertex.normal.x = mesh->mNormals[i].x;
@@ -87,9 +189,28 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene,
 		vertices.emplace_back(new_vertex);
 	}
 
+	/* ----- Find the mesh's bounds ----- */
+	if (mesh_bounds.IsValid()) {
+		// Center the sphere on the box, but only make it as big as the furthest vertex,
+		//   which is usually much tighter than the box's corners
+		BoundingSphere mesh_sphere(mesh_bounds.GetCenter(), 0.0f);
+		for (const Vertex& vertex : vertices) {
+			mesh_sphere.radius = std::max(mesh_sphere.radius,
+			                              glm::length(vertex.position - mesh_sphere.center));
+		}
+		if (data.bounds.IsValid()) {
+			data.boundingSphere.Expand(mesh_sphere);
+		}
+		else {
+			data.boundingSphere = mesh_sphere;
+		}
+		data.bounds.Expand(mesh_bounds);
+	}
+
 	/* ----- Process indices ----- */
 	// Assimp always stores each "face" (triangle) as a set of indices, so it's
 	//   already set up to use indexed drawing
+	indices.reserve(mesh->mNumFaces * 3);
 	for (size_t i = 0; i < mesh->mNumFaces; ++i) {
 		aiFace face = mesh->mFaces[i];
 		for (size_t j = 0; j < face.mNumIndices; ++j) {
@@ -105,30 +226,29 @@ void Model::ProcessMesh(aiMesh* mesh, const aiScene* scene,
 		//   textures for diffuse, specular, emissive, etc (see material.h)
 		// Load diffuse & specular textures
 		LoadTexturesFromMaterial(material, aiTextureType_DIFFUSE,
-			Texture::TextureType::DIFFUSE, textures, scene_ref);
+			Texture::TextureType::DIFFUSE, model_dir, textures);
 		LoadTexturesFromMaterial(material, aiTextureType_SPECULAR,
-			Texture::TextureType::SPECULAR, textures, scene_ref);
+			Texture::TextureType::SPECULAR, model_dir, textures);
 	}
-
-	meshList.emplace_back(std::make_shared<StaticMesh>(vertices, indices, textures));
 }
 
 void Model::LoadTexturesFromMaterial(aiMaterial* material,
 	aiTextureType ai_tex_type,
 	Texture::TextureType custom_tex_type,
-	std::vector<std::weak_ptr<Texture> >& tex_list,
-	std::weak_ptr<Scene> scene_ref) {
+	const std::string& model_dir,
+	std::vector<MeshCache::TextureRef>& tex_list) {
 
 	// Keep track of how many materials of each type have been encountered
 	
 
 	for (size_t i = 0; i < material->GetTextureCount(ai_tex_type); ++i) {
-		// Construct a texture object from the path in the material
+		// Store the texture's path. It's loaded when the mesh is added, so that cached
+		//   models load their textures the same way
 		aiString local_tex_path;
 
 		material->GetTexture(ai_tex_type, i, &local_tex_path);
-		std::string path = modelDir + "/" + std::string(local_tex_path.C_Str());
-		tex_list.emplace_back(scene_ref.lock()->GetTexture(path, custom_tex_type));
+		std::string path = model_dir + "/" + std::string(local_tex_path.C_Str());
+		tex_list.push_back(MeshCache::TextureRef{ custom_tex_type, path });
 		
 		// Note: if desired, you could also load more texture import options here, like
 		//   wrapping, 2 sided, etc. General idea here:
@@ -148,3 +268,14 @@ void Model::LoadTexturesFromMaterial(aiMaterial* material,
 		*/
 	}
 }
+
+void Model::AddMesh(const MeshCache::MeshView& mesh, std::weak_ptr<Scene> scene_ref) {
+	std::vector<std::shared_ptr<Texture> > textures;
+	textures.reserve(mesh.textures.size());
+	for (const MeshCache::TextureRef& texture : mesh.textures) {
+		textures.emplace_back(scene_ref.lock()->GetTexture(texture.path, texture.type));
+	}
+	meshList.emplace_back(std::make_shared<StaticMesh>(mesh.vertices, mesh.numVertices,
+	                                                    mesh.indices, mesh.numIndices,
+	                                                    textures, meshArena));
+}
@@ -6,38 +6,110 @@
 
 #include <assimp/scene.h>
 
+#include "MeshCache.h"
 #include "StaticMesh.h"
 #include "Texture.h"
-class ShaderProgram;
+#include "../Utils/Bounds.h"
 class Scene;
 
 ///
 /// A model is a collection of StaticMeshes and textures that are always drawn together.
 /// Meshes in a model may use different textures, but always use the same shader.
 /// The model class manages loading the mesh files from assimp and drawing the mesh objects.
+/// Imported meshes are baked into a MeshCache, so Assimp only runs the first time a model
+/// file is loaded. Reading a model is split from uploading it, so that files can be read
+/// on another thread (see AssetLoader).
+///
+/// If the mesh arena uses packed vertices, positions are stored relative to the model's
+/// bounds, and GetVertexTransform maps them back to model space. Quantizing against the
+/// whole model (rather than each mesh) lets every mesh share the model's instance data.
 ///
 class Model {
 public:
-	// Basic constructor - load from file
-	Model(const std::string& filename, std::weak_ptr<Scene> scene_ref);
+	// A mesh read from Assimp, before it's baked & uploaded
+	struct ImportedMesh {
+		std::vector<Vertex> vertices;
+		// The vertices quantized against the model's bounds, when packing is used. The full
+		//   vertices are released once these are made
+		std::vector<PackedVertex> packedVertices;
+		std::vector<GLuint> indices;
+		std::vector<MeshCache::TextureRef> textures;
+	};
+	// A model file's meshes, read but not uploaded yet
+	struct ModelData {
+		// Holds the meshes' data if they were read from the model's cache
+		MeshCache cache;
+		// Holds the meshes' data if they were imported with Assimp
+		std::vector<ImportedMesh> importedMeshes;
+		// Every mesh, pointing into whichever of the above was used
+		std::vector<MeshCache::MeshView> meshes;
+		AABB bounds;
+		BoundingSphere boundingSphere;
+		// Format of every mesh's vertices
+		VertexFormat vertexFormat = VertexFormat::FULL;
+
+		// Size of the vertex & index data that will be uploaded
+		size_t GetNumBytes() const;
+	};
+	// Read a model from its cache, or from the file if the cache is missing or out of date.
+	//   The vertices are read in vertex_format, which must match the arena's. Doesn't touch
+	//   OpenGL or the Scene, so it's safe to call from any thread
+	static std::unique_ptr<ModelData> ReadFile(const std::string& filename,
+	                                           const VertexFormat vertex_format);
+
+	// Load the model right away. Each mesh's vertex data is stored in mesh_arena. Must be
+	//   called on the GL thread
+	Model(const std::string& filename, std::weak_ptr<Scene> scene_ref,
+	      const std::shared_ptr<MeshArena>& mesh_arena);
+	// Create an empty model, to be filled in by Upload
+	Model(const std::shared_ptr<MeshArena>& mesh_arena);
 	~Model() = default;
 
-	// Render each mesh in the model, with an optional texture override
-	void Render(const std::shared_ptr<ShaderProgram>& shader,
-	            const std::weak_ptr<Texture> tex_override) const;
+	// Upload the meshes that were read from a file, and load their textures through the
+	//   scene. Must be called on the GL thread
+	void Upload(const ModelData& data, std::weak_ptr<Scene> scene_ref);
+
+	/* ----- Getters ----- */
+	// Has the model been uploaded? Empty models have no meshes and no bounds
+	bool IsLoaded() const;
+	// Size of the model's vertex & index data in the mesh arena (not counting textures)
+	size_t GetNumBytes() const;
+	// Meshes are drawn individually by the RenderQueue
+	const std::vector<std::shared_ptr<StaticMesh> >& GetMeshes() const;
+	// Bounds of every mesh in the model, in model space. Invalid if nothing was loaded
+	const AABB& GetBounds() const;
+	const BoundingSphere& GetBoundingSphere() const;
+	// Maps the meshes' vertex positions to model space. The identity, unless the vertices
+	//   are packed
+	const glm::mat4& GetVertexTransform() const;
+	// Format that the arena (and so this model's files) store vertices in
+	VertexFormat GetVertexFormat() const;
 
 private:
-	void ProcessNode(aiNode* node, const aiScene* scene,
-		std::weak_ptr<Scene> scene_ref);
-	void ProcessMesh(aiMesh* mesh, const aiScene* scene,
-		std::weak_ptr<Scene> scene_ref);
-	void LoadTexturesFromMaterial(aiMaterial* material,
-	                              aiTextureType ai_tex_type,
-	                              Texture::TextureType custom_tex_type,
-	                              std::vector<std::weak_ptr<Texture> >& tex_list,
-	                              std::weak_ptr<Scene> scene_ref);
-
-	// Directory holding this model's file (not including the model's filename)
-	std::string modelDir;
+	// Import the model file with Assimp, and bake it into a cache for next time
+	static void ImportFromFile(const std::string& filename, const VertexFormat vertex_format,
+	                           ModelData& data);
+	// model_dir is the directory holding the model file, which texture paths are
+	//   relative to
+	static void ProcessNode(aiNode* node, const aiScene* scene, const std::string& model_dir,
+	                        ModelData& data);
+	static void ProcessMesh(aiMesh* mesh, const aiScene* scene, const std::string& model_dir,
+	                        ModelData& data);
+	static void LoadTexturesFromMaterial(aiMaterial* material,
+	                                     aiTextureType ai_tex_type,
+	                                     Texture::TextureType custom_tex_type,
+	                                     const std::string& model_dir,
+	                                     std::vector<MeshCache::TextureRef>& tex_list);
+	// Load a mesh's textures through the scene, and upload the mesh
+	void AddMesh(const MeshCache::MeshView& mesh, std::weak_ptr<Scene> scene_ref);
+
+	// Where every mesh's vertex data is stored
+	std::shared_ptr<MeshArena> meshArena;
 	std::vector<std::shared_ptr<StaticMesh> > meshList;
+	bool loaded = false;
+	size_t numBytes = 0;
+	// Found while the meshes are read, for frustum culling
+	AABB bounds;
+	BoundingSphere boundingSphere;
+	glm::mat4 vertexTransform = glm::mat4(1.0f);
 };
\ No newline at end of file
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 #include <iostream>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "../Rendering/MeshArena.h"
+#include "../Utils/Bounds.h"
+class RenderStateCache;
 class Texture;
 class ShaderProgram;
 
@@ -28,41 +32,71 @@ struct Vertex {
 	}
 };
 
+///
+/// Quantized vertex, half the size of a Vertex (16 bytes instead of 32), for arenas using
+/// VertexFormat::PACKED. Positions are 16-bit fractions of the model's bounds, normals are
+/// signed 10-bit components, and texture coordinates are half floats. The positions have to
+/// be scaled back up by the model's vertex transform (see Model::GetVertexTransform)
+///
+struct PackedVertex {
+	// unorm16 xyz across the bounds, and w = 1
+	uint16_t position[4];
+	// GL_INT_2_10_10_10_REV: snorm10 xyz, then 2 unused bits
+	uint32_t normal;
+	// Half floats, so UVs outside [0, 1] (for repeating textures) still work
+	uint16_t texCoord[2];
+
+	PackedVertex() = default;
+	// Quantize 'vertex', whose position must be inside 'bounds'
+	PackedVertex(const Vertex& vertex, const AABB& bounds);
+};
+
 /// 
-/// Loads & stores vertex data for a single static mesh
+/// Uploads & draws the vertex data for a single static mesh. The vertex data only lives on
+/// the GPU, in a MeshArena that's shared by every mesh
 /// 
 class StaticMesh {
 public:
-	StaticMesh(std::vector<Vertex>& vertices,
-	           std::vector<GLuint>& indices,
-	           std::vector<std::weak_ptr<Texture> >& textures);
-	// Deallocate this mesh's GPU resources (Note : Do NOT make copies of static
+	// The vertex & index data is copied into the arena, so it only needs to stay valid
+	//   during the constructor. Vertices must be in the arena's vertex format
+	StaticMesh(const void* vertices, const GLuint num_vertices,
+	           const GLuint* indices, const GLuint num_indices,
+	           std::vector<std::shared_ptr<Texture> >& textures,
+	           const std::shared_ptr<MeshArena>& mesh_arena);
+	// Release this mesh's space in the arena (Note : Do NOT make copies of static
 	//   mesh objects to avoid accidental deallocation)
 	~StaticMesh();
 
-	// Draw the mesh, with an optional texture override
-	void Render(const std::shared_ptr<ShaderProgram> shader,
-	            const std::weak_ptr<Texture> tex_override) const;
+	// Bind this mesh's textures (or the texture override) and point the shader's samplers
+	//   at them. 'shader' must already be active, and all binds go through 'state'
+	void BindMaterial(RenderStateCache& state, ShaderProgram& shader,
+	                  const std::weak_ptr<Texture>& tex_override) const;
+	// Does 'other' bind exactly the same textures as this mesh? If so, both can be drawn
+	//   after a single BindMaterial
+	bool SharesMaterial(const StaticMesh& other) const;
+	// Indirect draw command for num_instances copies of the mesh, starting at base_instance
+	//   in the instance buffer
+	DrawElementsIndirectCommand GetDrawCommand(const GLuint base_instance,
+	                                           const GLuint num_instances) const;
 
-private:
-	void SetupVertexArray();
-
-	// Vertex Array Object - holds the mappings between buffers and attributes
-	GLuint vertexArrayID;
+	/* ----- Getters ----- */
+	// Same for every mesh, since they're all in the arena
+	GLuint GetVertexArrayID() const;
+	// ID that's shared by draws which bind the same textures, for sorting: the texture
+	//   override's ID if it's valid, otherwise this mesh's first texture's (or 0)
+	GLuint GetMaterialID(const std::weak_ptr<Texture>& tex_override) const;
 
-	// Vertex Buffer - Stores raw vertex data
-	// Note: all vertex data is currently stored in a single VBO. This is good when
-	//   vertex data doesn't change, but if position data changes often (i.e. cloth sim),
-	//   then keep position & normal in separate VBO from other data
-	std::vector<Vertex> vertexBuffer;
-	GLuint vertexBufferID;
-
-	// Element Buffer - stores the order to draw vertices in the vertexBuffer
-	std::vector<GLuint> elementBuffer;
-	GLuint elementBufferID;
+private:
+	// Shared by every mesh, and kept alive until the last mesh releases its space
+	std::shared_ptr<MeshArena> arena;
+	// Where this mesh's vertices & indices are in the arena
+	MeshArena::Allocation allocation;
 
-	// Array of textures used by this mesh. Since textures are small objects (just
-	//   an ID and type), each mesh can store full copies of its texture objects
-	std::vector<std::weak_ptr<Texture> > textureList;
+	// Array of textures used by this mesh. Holding them keeps them from being evicted
+	//   from the scene's texture cache while the mesh exists
+	std::vector<std::shared_ptr<Texture> > textureList;
+	// Sampler uniform name for each texture in textureList (i.e. "textureDiffuse0"). These
+	//   only depend on the texture types, so they're built once instead of on every draw
+	std::vector<std::string> samplerNames;
 };
 
@@ -1,22 +1,123 @@
 #include "Texture.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "stb_image.h"
+#include "BlockCompressor.h"
 
 Texture::Texture(const std::string& filepath, const TextureType type,
                  const TextureOptions options) :
+	textureID(0),
 	type(type),
-	textureID(0) {
-	LoadFromFile(filepath, options);
+	options(options) {
+	Upload(*ReadFile(filepath, options));
 }
 
+Texture::Texture(const TextureType type, const TextureOptions options) :
+	textureID(0),
+	type(type),
+	options(options) {}
+
 Texture::~Texture() {
 	// Deallocate the texture's GPU resources
 	glDeleteTextures(1, &textureID);
 }
 
-void Texture::LoadFromFile(const std::string& filename, TextureOptions options) {
+Texture::ImageData::~ImageData() {
+	stbi_image_free(pixels);
+}
+
+size_t Texture::ImageData::GetNumBytes() const {
+	if (compressed.IsLoaded()) {
+		return compressed.GetNumBytes();
+	}
+	return (size_t)width * height * numChannels;
+}
+
+std::unique_ptr<Texture::ImageData> Texture::ReadFile(const std::string& filename,
+                                                      const TextureOptions& options) {
+	auto image = std::make_unique<ImageData>();
+	image->filename = filename;
+	/* ----- Use the compressed version, baking it if needed ----- */
+	if (options.compress) {
+		if (image->compressed.Load(KTXFile::GetCachePath(filename), filename)) {
+			if (KTXFile::IsFormatSupported(image->compressed.GetInternalFormat())) {
+				return image;
+			}
+			// i.e. a BC7 file on a GPU that can't sample BC7. Fall back to the image
+			image->compressed.Close();
+		}
+		else if (CompressImage(*image, options)) {
+			return image;
+		}
+	}
+	/* ----- Otherwise, decode the image for an uncompressed upload ----- */
+	if (!image->pixels) {
+		DecodeImage(*image, 0);
+	}
+	return image;
+}
+
+void Texture::DecodeImage(ImageData& image, const int num_channels) {
+	// Load the texture data from the file
+	image.pixels = stbi_load(image.filename.c_str(), &image.width, &image.height,
+	                         &image.numChannels, num_channels);
+	if (!image.pixels) {
+		return;
+	}
+	// stb_image reports the file's channel count, even when it converts them
+	if (num_channels != 0) {
+		image.numChannels = num_channels;
+	}
+	// OpenGL expects the bottom row first. stb_image can flip images as they're loaded, but
+	//   that setting is global, so flip the rows here instead to keep threads from racing
+	const size_t row_size = (size_t)image.width * image.numChannels;
+	for (int y = 0; y < image.height / 2; ++y) {
+		unsigned char* top_row = image.pixels + y * row_size;
+		unsigned char* bottom_row = image.pixels + (image.height - 1 - y) * row_size;
+		std::swap_ranges(top_row, top_row + row_size, bottom_row);
+	}
+}
+
+bool Texture::CompressImage(ImageData& image, const TextureOptions& options) {
+	// Check the image's channels before decoding it, to pick the format. BC1 is half the
+	//   size of BC3, so it's used whenever the alpha channel won't be drawn
+	int width, height, file_channels;
+	if (!stbi_info(image.filename.c_str(), &width, &height, &file_channels)) {
+		return false;
+	}
+	const bool keep_alpha = (file_channels == 2 || file_channels == 4) &&
+	                        options.internalFormat != GL_RGB;
+	const GLenum format = keep_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT :
+	                                   GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	if (!KTXFile::IsFormatSupported(format)) {
+		return false;
+	}
+	// The compressor works on RGBA pixels
+	DecodeImage(image, 4);
+	if (!image.pixels) {
+		return false;
+	}
+	const std::vector<std::vector<uint8_t> > levels =
+		BlockCompressor::CompressMipChain(image.pixels, image.width, image.height, keep_alpha);
+	const std::string ktx_path = KTXFile::GetCachePath(image.filename);
+	if (!KTXFile::Write(ktx_path, image.filename, format, image.width, image.height, levels) ||
+	    !image.compressed.Load(ktx_path, image.filename)) {
+		// The decoded pixels are kept, so the image can still be uploaded uncompressed
+		return false;
+	}
+	stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+	return true;
+}
+
+void Texture::Upload(const ImageData& image) {
+	if (!image.compressed.IsLoaded() && !image.pixels) {
+		std::cerr << "ERROR: Failed to load texture \"" << image.filename << "\".";
+		std::cerr << std::endl;
+		return;
+	}
 	// Create the texture object
 	glGenTextures(1, &textureID);
 	// Set this texture as the current texture, to be modified by further opengl calls
@@ -29,12 +130,13 @@ void Texture::LoadFromFile(const std::string& filename, TextureOptions options)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, options.minFilter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, options.maxFilter);
 
-	// Load the texture data from the file
-	stbi_set_flip_vertically_on_load(true);
-	int width, height, num_channels;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &num_channels, 0);
+	if (image.compressed.IsLoaded()) {
+		UploadCompressed(image.compressed);
+		numBytes = image.compressed.GetNumBytes();
+		return;
+	}
 	GLenum external_format;
-	switch (num_channels) {
+	switch (image.numChannels) {
 	case 3:
 		external_format = GL_RGB;
 		break;
@@ -42,35 +144,41 @@ void Texture::LoadFromFile(const std::string& filename, TextureOptions options)
 		external_format = GL_RGBA;
 		break;
 	default:
-		std::cerr << "ERROR: Unhandled number of channels in loaded texture \"" << filename;
-		std::cerr << "\": " << num_channels << std::endl;
+		std::cerr << "ERROR: Unhandled number of channels in loaded texture \"";
+		std::cerr << image.filename << "\": " << image.numChannels << std::endl;
 		external_format = GL_RED;
 	}
-	if (data) {
-		// Create the texture object
-		// Arguments:
-		//   GLenum target - which texture object in the current context is being created?
-		//   GLint level - mipmap level to set (if you're setting them manually)
-		//   GLint internalformat - how should openGL store the texture?
-		//   GLsizei width, GLsizei height - texture's size
-		//   GLint border - always 0 (legacy stuff)
-		//   GLenum format - how is the texture represented in the file?
-		//     Khronos group docs say it must match internalformat, but still works
-		//     even if it doesn't
-		//   GLenum type - what datatype is used to represent the image in the file?
-		//   const void* pixels - the raw data
-		glTexImage2D(GL_TEXTURE_2D, 0, options.internalFormat, width, height, 0,
-			external_format, GL_UNSIGNED_BYTE, data);
-		// Let OpenGL create the other mipmaps automatically, instead of calling glTexImage2D for them
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else {
-		std::cerr << "ERROR: Failed to load texture \"" << filename << "\".";
-		std::cerr << std::endl;
-	}
-	stbi_image_free(data);
+	// Create the texture object
+	// Arguments:
+	//   GLenum target - which texture object in the current context is being created?
+	//   GLint level - mipmap level to set (if you're setting them manually)
+	//   GLint internalformat - how should openGL store the texture?
+	//   GLsizei width, GLsizei height - texture's size
+	//   GLint border - always 0 (legacy stuff)
+	//   GLenum format - how is the texture represented in the file?
+	//     Khronos group docs say it must match internalformat, but still works
+	//     even if it doesn't
+	//   GLenum type - what datatype is used to represent the image in the file?
+	//   const void* pixels - the raw data
+	glTexImage2D(GL_TEXTURE_2D, 0, options.internalFormat, image.width, image.height, 0,
+		external_format, GL_UNSIGNED_BYTE, image.pixels);
+	// Let OpenGL create the other mipmaps automatically, instead of calling glTexImage2D for them
+	glGenerateMipmap(GL_TEXTURE_2D);
+	// Drivers store RGB textures as RGBA, and the mips add another third
+	numBytes = (size_t)image.width * image.height * 4 * 4 / 3;
 }
 
+void Texture::UploadCompressed(const KTXFile& compressed) {
+	// The mip chain was built when the image was baked, so there's nothing to generate
+	const std::vector<KTXFile::MipLevel>& levels = compressed.GetLevels();
+	for (size_t i = 0; i < levels.size(); ++i) {
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, compressed.GetInternalFormat(),
+		                       levels[i].width, levels[i].height, 0, levels[i].numBytes,
+		                       levels[i].data);
+	}
+	// Files from other tools may stop before 1x1, so only sample the levels that exist
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+}
 
 void Texture::Bind(GLuint texture_unit) const {
 	// Check that the texture has been generated
@@ -90,10 +198,22 @@ bool Texture::IsLoaded() const {
 	return (textureID > 0);
 }
 
+GLuint Texture::GetID() const {
+	return textureID;
+}
+
 Texture::TextureType Texture::GetType() const {
 	return type;
 }
 
+const TextureOptions& Texture::GetOptions() const {
+	return options;
+}
+
+size_t Texture::GetNumBytes() const {
+	return numBytes;
+}
+
 void Texture::SetType(const TextureType new_type) {
 	type = new_type;
 }
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <iostream>
 
 #include <glad/glad.h>
 
+#include "KTXFile.h"
+
 struct TextureOptions {
 	// Sets GL_TEXTURE_WRAP_(S or T)
 	GLenum wrapType;
@@ -17,14 +20,20 @@ struct TextureOptions {
 	// TODO: test with getting rid of this (i.e. if I read in a RGBA or RED image and
 	//   represent it internally as RGBA or RED, will it cause issues?)
 	GLenum internalFormat;
+	// Should the texture be block-compressed on the GPU? If so, it's baked into a KTXFile
+	//   with its mip chain the first time it's loaded. Ignored if the GPU can't sample the
+	//   compressed formats
+	bool compress;
 	// Default constructor
 	TextureOptions() :
 		wrapType(GL_REPEAT), minFilter(GL_LINEAR_MIPMAP_LINEAR),
-		maxFilter(GL_LINEAR), internalFormat(GL_RGB) {}
+		maxFilter(GL_LINEAR), internalFormat(GL_RGB), compress(true) {}
 };
 
 /// 
-/// Loads textures from files and stores their OpenGL object ID's
+/// Loads textures from files and stores their OpenGL object ID's. A texture can also be
+/// created empty and filled in later, so that its file is decoded on another thread (see
+/// AssetLoader). Empty textures have an ID of 0, so they draw as black until they're ready
 /// 
 class Texture {
 public:
@@ -55,13 +64,41 @@ public:
 		return "undefined_texture_type";
 	}
 
+	// An image file, read but not uploaded yet. Holds either the compressed mip chain or
+	//   the decoded pixels. Frees the pixels when destroyed
+	struct ImageData {
+		std::string filename;
+		KTXFile compressed;
+		unsigned char* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		int numChannels = 0;
+
+		ImageData() = default;
+		~ImageData();
+		// Owns the pixels, so copying would free them twice
+		ImageData(const ImageData&) = delete;
+		ImageData& operator=(const ImageData&) = delete;
+		size_t GetNumBytes() const;
+	};
+	// Read an image file, preferring its compressed version. If it hasn't been compressed
+	//   yet, decode and compress it, and save the result for next time. Doesn't touch
+	//   OpenGL, so it's safe to call from any thread
+	static std::unique_ptr<ImageData> ReadFile(const std::string& filename,
+	                                           const TextureOptions& options);
+
 	/* ----- Class Definition ----- */
+	// Load the texture right away. Must be called on the GL thread
 	Texture(const std::string& filepath, const TextureType type,
 	        const TextureOptions options);
+	// Create an empty texture, to be filled in by Upload
+	Texture(const TextureType type, const TextureOptions options);
 	// Destructor deallocates this texture's GPU resources (Note: Do NOT make copies
 	//   of Texture objects to avoid accidental deallocation)
 	~Texture();
 
+	// Create the GL texture from a decoded image. Must be called on the GL thread
+	void Upload(const ImageData& image);
 	// Binds this texture to the provided texture unit (default = 0)
 	void Bind(GLuint texture_unit = 0) const;
 
@@ -69,6 +106,10 @@ public:
 	// Has this texture been correctly loaded from an image file?
 	bool IsLoaded() const;
 	TextureType GetType() const;
+	GLuint GetID() const;
+	const TextureOptions& GetOptions() const;
+	// GPU memory used by the texture, including its mips. 0 until it's uploaded
+	size_t GetNumBytes() const;
 
 	/* ----- Setters ----- */
 	void SetType(const TextureType new_type);
@@ -77,8 +118,17 @@ private:
 	// Texture properties
 	GLuint textureID;
 	TextureType type;
+	// Kept until the texture is uploaded
+	TextureOptions options;
+	size_t numBytes = 0;
 
-	// Load and allocate this texture
-	void LoadFromFile(const std::string& filename, TextureOptions options);
+	// Upload every level of a compressed image
+	void UploadCompressed(const KTXFile& compressed);
+	// Decode an image's file into its pixels, with num_channels channels (0 = however
+	//   many the file has)
+	static void DecodeImage(ImageData& image, const int num_channels);
+	// Decode & compress an image into its KTXFile. Returns false if it can't be compressed,
+	//   in which case the image may already be decoded
+	static bool CompressImage(ImageData& image, const TextureOptions& options);
 };
 
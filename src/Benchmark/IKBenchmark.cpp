@@ -0,0 +1,725 @@
+// Include order: std library, external libraries, project headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "../IK/ChainKinematics.h"
+#include "../IK/ChainSolver.h"
+#include "../IK/LegSolverBatch.h"
+#include "../IK/LinkObjective.h"
+#include "../IK/OptimizerCCD.h"
+#include "../IK/OptimizerFABRIK.h"
+#include "../IK/OptimizerGDLS.h"
+#include "../IK/OptimizerNM.h"
+
+///
+/// Standalone micro-benchmark comparing the per-chain IK path (one ChainSolver per
+/// leg, solved one after another) with the batched LegSolverBatch. Doesn't create a
+/// window or GL context, so it only links against the IK sources.
+///
+/// Also checks that the fixed-size solvers never allocate (every operator new is counted,
+/// and Debug builds define EIGEN_RUNTIME_NO_MALLOC), times each optimizer from a cold start
+/// and along replayed target trajectories, and times the forward kinematics in both
+/// precisions. Trajectory files hold one J-space target "x y" per line.
+///
+/// Usage: IKBenchmark [NUM_TICKS] [TRAJECTORY_FILE]
+///
+
+// Total number of allocations made through operator new
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+	++allocation_count;
+	void* ptr = std::malloc(size > 0 ? size : 1);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace {
+// Chain layout used by IKChain::BeginPlay
+const double link_offsets[8] = { 0.0, 0.4, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6 };
+const double pi = 3.1415926535;
+const double start_angles[8] = { pi / 4.0, (-7.0 * pi) / 12.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+std::vector<double> MakeOffsets(const size_t num_links) {
+	return std::vector<double>(link_offsets, link_offsets + num_links);
+}
+
+Eigen::VectorXd MakeStartAngles(const size_t num_links) {
+	Eigen::VectorXd angles(num_links);
+	for (size_t i = 0; i < num_links; ++i) {
+		angles(i) = start_angles[i];
+	}
+	return angles;
+}
+
+// Distance from the chain's root to the end effector when every link is straight
+double GetReach(const size_t num_links) {
+	double reach = 0.5;
+	for (size_t i = 0; i < num_links; ++i) {
+		reach += link_offsets[i];
+	}
+	return reach;
+}
+
+// Synthetic walking cycle: each leg's target slides backward while planted, then lifts
+//   and swings forward. Legs are phase-shifted so they don't all step at once
+Eigen::Vector2d GetTarget(const size_t chain_idx, const size_t tick, const size_t num_links) {
+	const double reach = GetReach(num_links);
+	const double phase = (tick / 60.0) * 2.0 * pi + chain_idx * 0.7;
+	const double x = reach * (0.6 + 0.15 * sin(phase));
+	const double y = reach * (-0.3 + 0.1 * std::max(0.0, cos(phase)));
+	return Eigen::Vector2d(x, y);
+}
+
+// Stepping cycle for an idle-but-shuffling spider: each leg's target stays planted for
+//   3/4 of the cycle, then swings to the other end of its stride. This is the case the
+//   result cache is meant for, since most legs are planted on most ticks
+Eigen::Vector2d GetSteppingTarget(const size_t chain_idx, const size_t tick,
+                                  const size_t num_links) {
+	const Eigen::Vector2d front = GetTarget(0, 15, num_links);
+	const Eigen::Vector2d back = GetTarget(0, 45, num_links);
+	// Offset each leg's cycle so that only one or two legs swing at a time
+	const size_t cycle_len = 120;
+	const size_t cycle_tick = (tick + chain_idx * 37) % cycle_len;
+	const size_t swing_len = cycle_len / 4;
+	if (cycle_tick >= swing_len) {
+		// Planted. Alternate between the front and back of the stride every cycle
+		return (((tick + chain_idx * 37) / cycle_len) % 2 == 0) ? front : back;
+	}
+	const double alpha = (double)cycle_tick / swing_len;
+	const bool to_front = (((tick + chain_idx * 37) / cycle_len) % 2 == 0);
+	return to_front ? (1.0 - alpha) * back + alpha * front : (1.0 - alpha) * front + alpha * back;
+}
+
+// Mean distance from each chain's end effector to its target on the given tick
+double MeanTargetError(const std::vector<Eigen::VectorXd>& angles, const size_t tick) {
+	const size_t num_links = angles.front().rows();
+	ChainKinematics<Eigen::Dynamic> kinematics;
+	kinematics.SetLinkOffsets(MakeOffsets(num_links));
+	kinematics.SetEndEffector(Eigen::Vector2d(0.5, 0.0));
+	double total = 0.0;
+	for (size_t c = 0; c < angles.size(); ++c) {
+		total += (kinematics.Evaluate(angles[c]) - GetTarget(c, tick, num_links)).norm();
+	}
+	return total / angles.size();
+}
+
+// Each Run function returns the mean time per tick, and sets out_iters to the mean number
+//   of optimizer iterations per chain per tick
+double RunPerChain(const size_t num_chains, const size_t num_links, const size_t num_ticks,
+                   const bool fixed_size, std::vector<Eigen::VectorXd>& out_angles,
+                   double& out_iters) {
+	std::vector<std::unique_ptr<ChainSolver> > solvers;
+	for (size_t c = 0; c < num_chains; ++c) {
+		solvers.emplace_back(ChainSolver::Create(num_links, ChainSolver::Method::Auto, fixed_size));
+		solvers.back()->SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	}
+	out_angles.assign(num_chains, MakeStartAngles(num_links));
+
+	size_t total_iters = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		for (size_t c = 0; c < num_chains; ++c) {
+			solvers[c]->Solve(GetTarget(c, tick, num_links), out_angles[c]);
+			total_iters += solvers[c]->GetLastStats().iterations;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	out_iters = (double)total_iters / (num_chains * num_ticks);
+	return std::chrono::duration<double, std::nano>(end - start).count() / num_ticks;
+}
+
+// Count the allocations made by num_ticks solves of a single chain, after one warmup
+//   solve. Should be 0 for any fixed-size chain
+size_t CountSolveAllocations(const size_t num_links, const size_t num_ticks) {
+	std::unique_ptr<ChainSolver> solver = ChainSolver::Create(num_links);
+	solver->SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	Eigen::VectorXd angles = MakeStartAngles(num_links);
+	solver->Solve(GetTarget(0, 0, num_links), angles);
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+	Eigen::internal::set_is_malloc_allowed(!solver->IsFixedSize());
+#endif
+	const size_t start_count = allocation_count;
+	for (size_t tick = 1; tick <= num_ticks; ++tick) {
+		solver->Solve(GetTarget(0, tick, num_links), angles);
+	}
+	const size_t num_allocations = allocation_count - start_count;
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+	Eigen::internal::set_is_malloc_allowed(true);
+#endif
+	return num_allocations;
+}
+
+double RunBatched(const size_t num_chains, const size_t num_links, const size_t num_ticks,
+                  std::vector<Eigen::VectorXd>& out_angles, double& out_iters) {
+	LegSolverBatch batch(num_chains, MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	for (size_t c = 0; c < num_chains; ++c) {
+		batch.SetAngles(c, MakeStartAngles(num_links));
+	}
+
+	size_t total_iters = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		for (size_t c = 0; c < num_chains; ++c) {
+			batch.SetTarget(c, GetTarget(c, tick, num_links));
+		}
+		batch.Solve();
+		for (size_t c = 0; c < num_chains; ++c) {
+			total_iters += batch.GetStats(c).iterations;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	out_iters = (double)total_iters / (num_chains * num_ticks);
+
+	out_angles.resize(num_chains);
+	for (size_t c = 0; c < num_chains; ++c) {
+		batch.GetAngles(c, out_angles[c]);
+	}
+	return std::chrono::duration<double, std::nano>(end - start).count() / num_ticks;
+}
+
+// The per-chain pipeline from before damped newton's method: a GDLS pre-pass, then newton's
+//   method from where it left off, keeping whichever result is better
+template <int N>
+class OptimizerGDLSNM : public Optimizer<N> {
+public:
+	typedef typename Optimizer<N>::Vector Vector;
+
+	OptimizerGDLSNM(const int num_links) : gdls(num_links), nm(num_links) {
+		xGDLS.setZero(num_links);
+		xNM.setZero(num_links);
+	}
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x) {
+		xGDLS = x;
+		gdls.optimize(objective, xGDLS);
+		xNM = xGDLS;
+		nm.optimize(objective, xNM);
+		x = (objective.evalObjective(xNM) < objective.evalObjective(xGDLS)) ? xNM : xGDLS;
+	}
+	virtual int getIter() const { return gdls.getIter() + nm.getIter(); }
+
+private:
+	OptimizerGDLS<N> gdls;
+	OptimizerNM<N> nm;
+	Vector xGDLS;
+	Vector xNM;
+};
+
+// Random reachable targets, spread over the area in front of and below the chain's root
+std::vector<Eigen::Vector2d> MakeRandomTargets(const size_t num_targets, const size_t num_links) {
+	const double reach = GetReach(num_links);
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> dist_radius(0.3 * reach, 0.9 * reach);
+	std::uniform_real_distribution<double> dist_angle(-pi / 2.0, pi / 4.0);
+	std::vector<Eigen::Vector2d> targets(num_targets);
+	for (Eigen::Vector2d& target : targets) {
+		const double radius = dist_radius(rng);
+		const double angle = dist_angle(rng);
+		target = radius * Eigen::Vector2d(cos(angle), sin(angle));
+	}
+	return targets;
+}
+
+// Results from running one optimizer on every target of the time-to-tolerance benchmark
+struct ToleranceResult {
+	// Mean time & iterations per solve
+	double ns = 0.0;
+	double iters = 0.0;
+	// Mean distance from the end effector to the target
+	double err = 0.0;
+	// Objective value reached for each target
+	std::vector<double> f;
+};
+
+// Solve for every target from the chain's starting pose, letting the optimizer run until
+//   its own stopping criteria are met
+template <int N>
+ToleranceResult RunToTolerance(const size_t num_links, Optimizer<N>& optimizer,
+                               const std::vector<Eigen::Vector2d>& targets) {
+	typedef typename LinkObjective<N>::Vector Vector;
+	LinkObjective<N> objective;
+	objective.SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	const Vector start = MakeStartAngles(num_links);
+	Vector x = start;
+
+	ToleranceResult result;
+	result.f.resize(targets.size());
+	size_t total_iters = 0;
+	double total_ns = 0.0;
+	for (size_t i = 0; i < targets.size(); ++i) {
+		objective.SetTarget(targets[i]);
+		x = start;
+		auto solve_start = std::chrono::steady_clock::now();
+		optimizer.optimize(objective, x);
+		auto solve_end = std::chrono::steady_clock::now();
+		total_ns += std::chrono::duration<double, std::nano>(solve_end - solve_start).count();
+		total_iters += optimizer.getIter();
+		result.err += (objective.GetKinematics().Evaluate(x) - targets[i]).norm();
+		result.f[i] = objective.evalObjective(x);
+	}
+	result.ns = total_ns / targets.size();
+	result.iters = (double)total_iters / targets.size();
+	result.err /= targets.size();
+	return result;
+}
+
+// Mean relative distance of f above the best objective value that any of the results
+//   reached for the same target. Each result must have an objective value 'f' per target
+template <typename Results>
+double MeanObjectiveGap(const std::vector<double>& f, const Results& results) {
+	double gap = 0.0;
+	for (size_t i = 0; i < f.size(); ++i) {
+		double best = f[i];
+		for (const auto& other : results) {
+			best = std::min(best, other.f[i]);
+		}
+		gap += (f[i] - best) / best;
+	}
+	return gap / f.size();
+}
+
+// Print one row of the time-to-tolerance table, with each method's objective gap
+template <int N>
+void PrintToleranceRow(const size_t num_links, const size_t num_targets) {
+	const std::vector<Eigen::Vector2d> targets = MakeRandomTargets(num_targets, num_links);
+	OptimizerGDLSNM<N> gdls_nm(num_links);
+	OptimizerNM<N> nm(num_links);
+	OptimizerFABRIK<N> fabrik(num_links);
+	OptimizerCCD<N> ccd(num_links);
+	const ToleranceResult results[4] = {
+		RunToTolerance<N>(num_links, gdls_nm, targets),
+		RunToTolerance<N>(num_links, nm, targets),
+		RunToTolerance<N>(num_links, fabrik, targets),
+		RunToTolerance<N>(num_links, ccd, targets)
+	};
+
+	std::cout << std::setw(8) << num_links;
+	for (const ToleranceResult& result : results) {
+		const double gap = MeanObjectiveGap(result.f, results);
+		std::cout << std::setw(10) << std::fixed << std::setprecision(0) << result.ns
+		          << std::setw(7) << std::setprecision(1) << result.iters
+		          << std::setw(10) << std::scientific << std::setprecision(1) << result.err
+		          << std::setw(9) << gap << std::defaultfloat;
+	}
+	std::cout << std::endl;
+}
+
+// Target trajectory replayed by the solver benchmark, with one J-space target per tick
+struct Trajectory {
+	std::string name;
+	std::vector<Eigen::Vector2d> targets;
+};
+
+Trajectory MakeWalkingTrajectory(const size_t num_links, const size_t num_ticks) {
+	Trajectory trajectory{ "walking", std::vector<Eigen::Vector2d>(num_ticks) };
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		trajectory.targets[tick] = GetTarget(0, tick, num_links);
+	}
+	return trajectory;
+}
+
+// The spider turns in place at its default turn speed while the foot stays planted, so
+//   the foot's distance from the leg's root changes as the root swings around the body.
+//   Once the root has swung far enough past the foot, the foot steps to its new resting
+//   spot. Only the distance matters, since the chain aims itself at the target
+Trajectory MakeTurningTrajectory(const size_t num_links, const size_t num_ticks) {
+	const double reach = GetReach(num_links);
+	const double turn_per_tick = 1.2 / 60.0;
+	const double root_radius = 0.3;
+	const double foot_radius = root_radius + 0.6 * reach;
+	const double max_lag = 0.35;
+	const size_t step_ticks = 6;
+	Trajectory trajectory{ "turning", std::vector<Eigen::Vector2d>(num_ticks) };
+	double planted_angle = 0.0;
+	double step_from = 0.0;
+	size_t step_tick = step_ticks;
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		const double body_angle = tick * turn_per_tick;
+		if (step_tick >= step_ticks && body_angle - planted_angle > max_lag) {
+			step_from = planted_angle;
+			step_tick = 0;
+		}
+		if (step_tick < step_ticks) {
+			++step_tick;
+			const double alpha = (double)step_tick / step_ticks;
+			planted_angle = (1.0 - alpha) * step_from + alpha * body_angle;
+		}
+		const Eigen::Vector2d root = root_radius * Eigen::Vector2d(cos(body_angle), sin(body_angle));
+		const Eigen::Vector2d foot = foot_radius *
+			Eigen::Vector2d(cos(planted_angle), sin(planted_angle));
+		trajectory.targets[tick] = Eigen::Vector2d((foot - root).norm(), -0.3 * reach);
+	}
+	return trajectory;
+}
+
+// The target sweeps out from half the chain's reach to 1.5x its reach and back, so the
+//   chain spends part of every cycle stretched toward a target it can't reach
+Trajectory MakeReachingTrajectory(const size_t num_links, const size_t num_ticks) {
+	const double reach = GetReach(num_links);
+	const size_t cycle_len = 240;
+	Trajectory trajectory{ "reaching", std::vector<Eigen::Vector2d>(num_ticks) };
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		const double phase = (double)(tick % cycle_len) / cycle_len * 2.0 * pi;
+		const double dist = reach * (1.0 - 0.5 * cos(phase));
+		trajectory.targets[tick] = dist * Eigen::Vector2d(cos(-0.4), sin(-0.4));
+	}
+	return trajectory;
+}
+
+// Load a recorded trajectory. Returns false (and prints an error) if the file can't be read
+bool LoadTrajectory(const std::string& filename, Trajectory& out_trajectory) {
+	std::ifstream file(filename);
+	if (!file.is_open()) {
+		std::cerr << "ERROR: Could not open trajectory file " << filename << std::endl;
+		return false;
+	}
+	out_trajectory.name = filename;
+	out_trajectory.targets.clear();
+	std::string line;
+	while (std::getline(file, line)) {
+		line = line.substr(0, line.find('#'));
+		std::istringstream line_stream(line);
+		double x, y;
+		if (line_stream >> x >> y) {
+			out_trajectory.targets.emplace_back(x, y);
+		}
+	}
+	if (out_trajectory.targets.empty()) {
+		std::cerr << "ERROR: Trajectory file " << filename << " has no targets" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Names of the solver methods compared by the trajectory benchmark. Everything besides
+//   gdls+nm is a ChainSolver::Method name
+const char* replay_methods[] = { "auto", "newton", "fabrik", "ccd", "gdls+nm" };
+
+// Make a per-chain solver running GDLS followed by newton's method
+template <int N>
+std::unique_ptr<ChainSolver> MakeGDLSNMSolver(const size_t num_links) {
+	return std::make_unique<ChainSolverN<N> >(num_links,
+		std::make_unique<OptimizerGDLSNM<N> >(num_links));
+}
+
+std::unique_ptr<ChainSolver> MakeReplaySolver(const std::string& method, const size_t num_links) {
+	if (method != "gdls+nm") {
+		return ChainSolver::Create(num_links, ChainSolver::ParseMethod(method));
+	}
+	switch (num_links) {
+	case 2: return MakeGDLSNMSolver<2>(num_links);
+	case 3: return MakeGDLSNMSolver<3>(num_links);
+	case 4: return MakeGDLSNMSolver<4>(num_links);
+	case 5: return MakeGDLSNMSolver<5>(num_links);
+	case 6: return MakeGDLSNMSolver<6>(num_links);
+	case 7: return MakeGDLSNMSolver<7>(num_links);
+	default: return MakeGDLSNMSolver<Eigen::Dynamic>(num_links);
+	}
+}
+
+// Results from replaying one trajectory through one solver
+struct ReplayResult {
+	// Mean time & optimizer iterations per solve
+	double ns = 0.0;
+	double iters = 0.0;
+	// Mean distance from the end effector to the target over every tick, and on the last tick
+	double meanErr = 0.0;
+	double finalErr = 0.0;
+	// Mean calls to operator new per solve, not counting the first (warmup) solve
+	double allocs = 0.0;
+	// Objective value reached on each tick
+	std::vector<double> f;
+};
+
+// Solve for each target in order, warm-starting every solve from the previous result like
+//   IKChain does. Only the Solve calls themselves are timed and checked for allocations
+ReplayResult ReplayTrajectory(ChainSolver& solver, const size_t num_links,
+                              const Trajectory& trajectory) {
+	solver.SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	LinkObjective<Eigen::Dynamic> objective;
+	objective.SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+	Eigen::VectorXd angles = MakeStartAngles(num_links);
+
+	ReplayResult result;
+	const size_t num_ticks = trajectory.targets.size();
+	result.f.resize(num_ticks);
+	size_t total_iters = 0;
+	size_t total_allocs = 0;
+	double total_ns = 0.0;
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		const Eigen::Vector2d& target = trajectory.targets[tick];
+		const size_t start_count = allocation_count;
+		auto start = std::chrono::steady_clock::now();
+		solver.Solve(target, angles);
+		auto end = std::chrono::steady_clock::now();
+		if (tick > 0) {
+			total_allocs += allocation_count - start_count;
+		}
+		total_ns += std::chrono::duration<double, std::nano>(end - start).count();
+		total_iters += solver.GetLastStats().iterations;
+
+		const double err = (objective.GetKinematics().Evaluate(angles) - target).norm();
+		result.meanErr += err;
+		result.finalErr = err;
+		objective.SetTarget(target);
+		result.f[tick] = objective.evalObjective(angles);
+	}
+	result.ns = total_ns / num_ticks;
+	result.iters = (double)total_iters / num_ticks;
+	result.meanErr /= num_ticks;
+	result.allocs = (num_ticks > 1) ? (double)total_allocs / (num_ticks - 1) : 0.0;
+	return result;
+}
+
+// Print a table row for every solver method on the given trajectory, with each method's
+//   objective gap on every tick
+void PrintReplayRows(const Trajectory& trajectory, const size_t num_links) {
+	std::vector<ReplayResult> results;
+	for (const char* method : replay_methods) {
+		std::unique_ptr<ChainSolver> solver = MakeReplaySolver(method, num_links);
+		results.emplace_back(ReplayTrajectory(*solver, num_links, trajectory));
+	}
+	for (size_t i = 0; i < results.size(); ++i) {
+		const ReplayResult& result = results[i];
+		std::cout << std::setw(10) << trajectory.name << std::setw(8) << num_links
+		          << std::setw(10) << replay_methods[i]
+		          << std::setw(10) << std::fixed << std::setprecision(0) << result.ns
+		          << std::setw(8) << std::setprecision(1) << result.iters
+		          << std::setw(10) << std::scientific << std::setprecision(1)
+		          << MeanObjectiveGap(result.f, results)
+		          << std::setw(12) << std::setprecision(2) << result.meanErr
+		          << std::setw(12) << result.finalErr
+		          << std::setw(10) << std::fixed << result.allocs
+		          << std::defaultfloat << std::endl;
+	}
+}
+
+// Time ChainKinematics::Evaluate over the walking cycle for num_chains chains, with link
+//   data of the given precision. Returns the mean time per chain per tick, and sets
+//   out_end to chain 0's end effector on the last tick
+template <int N, typename Scalar>
+double RunKinematics(const size_t num_chains, const size_t num_links, const size_t num_ticks,
+                     Eigen::Vector2d& out_end) {
+	typedef ChainKinematics<N, Scalar> Kinematics;
+	std::vector<Kinematics, Eigen::aligned_allocator<Kinematics> > chains(num_chains);
+	for (Kinematics& chain : chains) {
+		chain.SetLinkOffsets(MakeOffsets(num_links));
+		chain.SetEndEffector(Eigen::Vector2d(0.5, 0.0));
+	}
+	// Angles for each tick, made ahead of time so that only the FK is timed
+	std::vector<typename Kinematics::Vector,
+		Eigen::aligned_allocator<typename Kinematics::Vector> > tick_angles(num_ticks);
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		tick_angles[tick] = MakeStartAngles(num_links) * (1.0 + 0.2 * sin(tick * 0.05));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		for (Kinematics& chain : chains) {
+			out_end = chain.Evaluate(tick_angles[tick]);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	out_end = chains[0].Evaluate(tick_angles[num_ticks - 1]);
+	return std::chrono::duration<double, std::nano>(end - start).count() /
+		(num_ticks * num_chains);
+}
+
+// Print one row of the forward kinematics table, comparing both link data precisions
+template <int N>
+void PrintKinematicsRow(const size_t num_links, const size_t num_ticks) {
+	Eigen::Vector2d end_double, end_float;
+	const double double_ns = RunKinematics<N, double>(64, num_links, num_ticks, end_double);
+	const double float_ns = RunKinematics<N, float>(64, num_links, num_ticks, end_float);
+	std::cout << std::setw(8) << num_links
+	          << std::setw(12) << std::fixed << std::setprecision(1) << double_ns
+	          << std::setw(12) << float_ns
+	          << std::setw(14) << std::scientific << std::setprecision(2)
+	          << (end_double - end_float).norm() << std::defaultfloat << std::endl;
+}
+
+// Run the stepping cycle with the given target epsilon. Returns the mean time per tick, and
+//   sets out_hit_rate to the fraction of solves that were skipped
+double RunStepping(const size_t num_chains, const size_t num_links, const size_t num_ticks,
+                   const double epsilon, double& out_hit_rate) {
+	std::vector<std::unique_ptr<ChainSolver> > solvers;
+	for (size_t c = 0; c < num_chains; ++c) {
+		solvers.emplace_back(ChainSolver::Create(num_links));
+		solvers.back()->SetChainGeometry(MakeOffsets(num_links), Eigen::Vector2d(0.5, 0.0));
+		solvers.back()->SetTargetEpsilon(epsilon);
+	}
+	std::vector<Eigen::VectorXd> angles(num_chains, MakeStartAngles(num_links));
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		for (size_t c = 0; c < num_chains; ++c) {
+			solvers[c]->Solve(GetSteppingTarget(c, tick, num_links), angles[c]);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	size_t num_hits = 0;
+	for (const auto& solver : solvers) {
+		num_hits += solver->GetNumCacheHits();
+	}
+	out_hit_rate = (double)num_hits / (num_chains * num_ticks);
+	return std::chrono::duration<double, std::nano>(end - start).count() / num_ticks;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+	size_t num_ticks = 2000;
+	if (argc > 1) {
+		num_ticks = std::stoul(argv[1]);
+	}
+	Trajectory recorded;
+	const bool has_recorded = (argc > 2) && LoadTrajectory(argv[2], recorded);
+
+	// Make sure the fixed-size solvers are allocation-free before timing anything
+	bool allocation_check_passed = true;
+	std::cout << "Allocations per solve (" << num_ticks << " solves)" << std::endl;
+	for (size_t num_links = ChainSolver::MIN_FIXED_LINKS;
+	     num_links <= ChainSolver::MAX_FIXED_LINKS; ++num_links) {
+		const bool fixed_size = ChainSolver::Create(num_links)->IsFixedSize();
+		const size_t num_allocations = CountSolveAllocations(num_links, num_ticks);
+		std::cout << std::setw(8) << num_links << " links: "
+		          << (fixed_size ? "fixed  " : "dynamic") << std::setw(10)
+		          << (double)num_allocations / num_ticks << std::endl;
+		if (fixed_size && num_allocations > 0) {
+			std::cerr << "ERROR: fixed-size solver with " << num_links
+			          << " links allocated during a solve!" << std::endl;
+			allocation_check_passed = false;
+		}
+	}
+	std::cout << std::endl;
+
+	std::cout << "IK batch benchmark (" << num_ticks << " ticks per run)" << std::endl;
+	std::cout << std::setw(8) << "chains" << std::setw(8) << "links"
+	          << std::setw(14) << "dynamic ns" << std::setw(14) << "fixed ns"
+	          << std::setw(14) << "batched ns" << std::setw(10) << "speedup"
+	          << std::setw(12) << "fixed iters" << std::setw(12) << "batch iters"
+	          << std::setw(14) << "dynamic err" << std::setw(14) << "fixed err"
+	          << std::setw(14) << "batched err" << std::endl;
+
+	const size_t chain_counts[] = { 2, 8, 16, 32, 64 };
+	const size_t link_counts[] = { 2, 4, 7 };
+	for (size_t num_links : link_counts) {
+		for (size_t num_chains : chain_counts) {
+			std::vector<Eigen::VectorXd> dynamic_angles;
+			std::vector<Eigen::VectorXd> fixed_angles;
+			std::vector<Eigen::VectorXd> batched_angles;
+			double dynamic_iters, fixed_iters, batched_iters;
+			double dynamic_ns = RunPerChain(num_chains, num_links, num_ticks, false, dynamic_angles,
+			                                dynamic_iters);
+			double fixed_ns = RunPerChain(num_chains, num_links, num_ticks, true, fixed_angles,
+			                              fixed_iters);
+			double batched_ns = RunBatched(num_chains, num_links, num_ticks, batched_angles,
+			                               batched_iters);
+
+			// All paths solve the same problem, so they should reach the targets equally
+			//   well. Note: the poses themselves can drift apart over many ticks, since
+			//   newton's method amplifies tiny rounding differences on this non-convex problem
+			double dynamic_err = MeanTargetError(dynamic_angles, num_ticks - 1);
+			double fixed_err = MeanTargetError(fixed_angles, num_ticks - 1);
+			double batched_err = MeanTargetError(batched_angles, num_ticks - 1);
+
+			// Speedup is for the batched solver, relative to the fastest per-chain path
+			std::cout << std::setw(8) << num_chains << std::setw(8) << num_links
+			          << std::setw(14) << std::fixed << std::setprecision(0) << dynamic_ns
+			          << std::setw(14) << fixed_ns << std::setw(14) << batched_ns
+			          << std::setw(10) << std::setprecision(2)
+			          << std::min(dynamic_ns, fixed_ns) / batched_ns
+			          << std::setw(12) << fixed_iters << std::setw(12) << batched_iters
+			          << std::setw(14) << std::scientific << dynamic_err
+			          << std::setw(14) << fixed_err << std::setw(14) << batched_err
+			          << std::defaultfloat << std::endl;
+		}
+	}
+
+	std::cout << std::endl << "IK result cache, stepping cycle (" << num_ticks
+	          << " ticks per run)" << std::endl;
+	std::cout << std::setw(8) << "chains" << std::setw(8) << "links"
+	          << std::setw(14) << "no cache ns" << std::setw(14) << "cached ns"
+	          << std::setw(10) << "speedup" << std::setw(10) << "hit rate" << std::endl;
+	for (size_t num_links : link_counts) {
+		const size_t num_chains = 8;
+		double uncached_hit_rate, cached_hit_rate;
+		double uncached_ns = RunStepping(num_chains, num_links, num_ticks, 0.0, uncached_hit_rate);
+		double cached_ns = RunStepping(num_chains, num_links, num_ticks, 1e-4, cached_hit_rate);
+		std::cout << std::setw(8) << num_chains << std::setw(8) << num_links
+		          << std::setw(14) << std::fixed << std::setprecision(0) << uncached_ns
+		          << std::setw(14) << cached_ns
+		          << std::setw(10) << std::setprecision(2) << uncached_ns / cached_ns
+		          << std::setw(10) << cached_hit_rate << std::defaultfloat << std::endl;
+	}
+
+	std::cout << std::endl << "IK time to tolerance, cold start (" << num_ticks
+	          << " random targets per run)" << std::endl;
+	std::cout << std::setw(8) << "";
+	const char* method_names[4] = { "GDLS+NM", "NM", "FABRIK", "CCD" };
+	for (const char* name : method_names) {
+		std::cout << std::setw(36) << name;
+	}
+	std::cout << std::endl << std::setw(8) << "links";
+	for (size_t i = 0; i < 4; ++i) {
+		std::cout << std::setw(10) << "ns" << std::setw(7) << "iters"
+		          << std::setw(10) << "err" << std::setw(9) << "f gap";
+	}
+	std::cout << std::endl;
+	PrintToleranceRow<2>(2, num_ticks);
+	PrintToleranceRow<3>(3, num_ticks);
+	PrintToleranceRow<4>(4, num_ticks);
+	PrintToleranceRow<5>(5, num_ticks);
+	PrintToleranceRow<6>(6, num_ticks);
+	PrintToleranceRow<7>(7, num_ticks);
+	PrintToleranceRow<Eigen::Dynamic>(8, num_ticks);
+
+	std::cout << std::endl << "IK trajectory replay (" << num_ticks
+	          << " ticks per synthetic trajectory)" << std::endl;
+	std::cout << std::setw(10) << "path" << std::setw(8) << "links" << std::setw(10) << "method"
+	          << std::setw(10) << "ns" << std::setw(8) << "iters" << std::setw(10) << "f gap"
+	          << std::setw(12) << "mean err"
+	          << std::setw(12) << "final err" << std::setw(10) << "allocs" << std::endl;
+	for (size_t num_links : link_counts) {
+		PrintReplayRows(MakeWalkingTrajectory(num_links, num_ticks), num_links);
+		PrintReplayRows(MakeTurningTrajectory(num_links, num_ticks), num_links);
+		PrintReplayRows(MakeReachingTrajectory(num_links, num_ticks), num_links);
+		if (has_recorded) {
+			PrintReplayRows(recorded, num_links);
+		}
+	}
+
+	std::cout << std::endl << "IK forward kinematics (" << num_ticks << " ticks, 64 chains)"
+	          << std::endl;
+	std::cout << std::setw(8) << "links" << std::setw(12) << "double ns" << std::setw(12)
+	          << "float ns" << std::setw(14) << "float err" << std::endl;
+	PrintKinematicsRow<2>(2, num_ticks);
+	PrintKinematicsRow<4>(4, num_ticks);
+	PrintKinematicsRow<7>(7, num_ticks);
+
+	return allocation_check_passed ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Include order: std library, external libraries, project headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../Utils/AffineTransform.h"
+#include "../Utils/Transform.h"
+
+///
+/// Standalone micro-benchmark comparing the TransformSystem's world matrix update
+/// (AffineTransform with a cached rotation basis) against building each local matrix with
+/// full mat4 multiplies. Only depends on the header-only Transform types.
+///
+/// Usage: TransformBenchmark [NUM_TICKS]
+///
+
+namespace {
+// Local matrix built the way Transform::GetMatrix used to: translate, then a full mat4
+//   multiply by the rotation, then scale
+glm::mat4 GetMatrixMat4(const Transform& t) {
+	glm::mat4 M(1.0f);
+	M = glm::translate(M, t.loc);
+	M *= glm::mat4_cast(t.rot);
+	M = glm::scale(M, t.scale);
+	return M;
+}
+
+struct TransformResult {
+	// Mean time per node per tick, for the world matrix update and for reading the
+	//   forward & right vectors
+	double mat4Ns = 0.0;
+	double affineNs = 0.0;
+	double mat4BasisNs = 0.0;
+	double cachedBasisNs = 0.0;
+	// Largest difference between the two paths' world matrices
+	float maxError = 0.0f;
+};
+
+// Update the world matrices of num_legs legs of num_links nodes each (every node parented to
+//   the previous one in its leg), both ways. If 'rotate' is true, every rotation changes each
+//   tick, so the basis cache never hits. Otherwise only the locations change
+TransformResult RunTransformUpdate(const size_t num_legs, const size_t num_links,
+                                   const size_t num_ticks, const bool rotate) {
+	const size_t num_nodes = num_legs * num_links;
+	std::vector<Transform> locals(num_nodes);
+	for (size_t i = 0; i < num_nodes; ++i) {
+		locals[i].loc = glm::vec3(1.0f, 0.1f * (i % num_links), 0.0f);
+		locals[i].rot = Transform::EulerToQuat(glm::vec3(0.1f, 0.2f * i, 0.3f));
+		locals[i].scale = glm::vec3(1.0f + 0.01f * i);
+	}
+	std::vector<glm::mat4> mat4_worlds(num_nodes, glm::mat4(1.0f));
+	std::vector<glm::mat4> affine_worlds(num_nodes, glm::mat4(1.0f));
+	// Sum of the basis vectors, so the reads can't be optimized out
+	glm::vec3 basis_sum(0.0f);
+	double mat4_ns = 0.0, affine_ns = 0.0, mat4_basis_ns = 0.0, cached_basis_ns = 0.0;
+	TransformResult result;
+
+	for (size_t tick = 0; tick < num_ticks; ++tick) {
+		// Move the nodes outside the timed sections
+		for (size_t i = 0; i < num_nodes; ++i) {
+			locals[i].loc.y = 0.1f * sin(0.01f * tick + i);
+			if (rotate) {
+				locals[i].AddRotationOffset(0.01f, glm::vec3(0.0f, 0.0f, 1.0f));
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < num_nodes; ++i) {
+			if (i % num_links == 0) {
+				mat4_worlds[i] = GetMatrixMat4(locals[i]);
+			}
+			else {
+				mat4_worlds[i] = mat4_worlds[i - 1] * GetMatrixMat4(locals[i]);
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+		mat4_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < num_nodes; ++i) {
+			if (i % num_links == 0) {
+				affine_worlds[i] = locals[i].GetMatrix();
+			}
+			else {
+				AffineTransform::Compose(affine_worlds[i - 1], locals[i].GetAffine(),
+				                         affine_worlds[i]);
+			}
+		}
+		end = std::chrono::steady_clock::now();
+		affine_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+		// Same reads as SpiderCharacter::GetLinearVelocity
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < num_nodes; ++i) {
+			const glm::mat4 R = glm::mat4_cast(locals[i].rot);
+			basis_sum += glm::vec3(R[2]) + glm::vec3(glm::mat4_cast(locals[i].rot)[0]);
+		}
+		end = std::chrono::steady_clock::now();
+		mat4_basis_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < num_nodes; ++i) {
+			basis_sum += locals[i].GetForwardVector() + locals[i].GetRightVector();
+		}
+		end = std::chrono::steady_clock::now();
+		cached_basis_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+		for (size_t i = 0; i < num_nodes; ++i) {
+			for (int col = 0; col < 4; ++col) {
+				for (int row = 0; row < 4; ++row) {
+					result.maxError = std::max(result.maxError,
+						std::abs(mat4_worlds[i][col][row] - affine_worlds[i][col][row]));
+				}
+			}
+		}
+	}
+	if (!std::isfinite(basis_sum.x)) {
+		std::cerr << "ERROR: transform benchmark produced a non-finite basis" << std::endl;
+	}
+
+	const double num_samples = (double)num_ticks * num_nodes;
+	result.mat4Ns = mat4_ns / num_samples;
+	result.affineNs = affine_ns / num_samples;
+	result.mat4BasisNs = mat4_basis_ns / num_samples;
+	result.cachedBasisNs = cached_basis_ns / num_samples;
+	return result;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+	size_t num_ticks = 2000;
+	if (argc > 1) {
+		num_ticks = std::stoul(argv[1]);
+	}
+
+	const size_t link_counts[] = { 2, 4, 7 };
+	std::cout << "Transform world matrix update (" << num_ticks
+	          << " ticks, 64 legs, ns per node)" << std::endl;
+	std::cout << std::setw(10) << "rotation" << std::setw(8) << "links"
+	          << std::setw(10) << "mat4" << std::setw(10) << "affine" << std::setw(10) << "speedup"
+	          << std::setw(12) << "mat4 basis" << std::setw(12) << "cached"
+	          << std::setw(10) << "speedup" << std::setw(12) << "max err" << std::endl;
+	for (const bool rotate : { false, true }) {
+		for (size_t num_links : link_counts) {
+			const TransformResult result = RunTransformUpdate(64, num_links, num_ticks, rotate);
+			std::cout << std::setw(10) << (rotate ? "changing" : "fixed") << std::setw(8) << num_links
+			          << std::setw(10) << std::fixed << std::setprecision(2) << result.mat4Ns
+			          << std::setw(10) << result.affineNs
+			          << std::setw(10) << result.mat4Ns / result.affineNs
+			          << std::setw(12) << result.mat4BasisNs << std::setw(12) << result.cachedBasisNs
+			          << std::setw(10) << result.mat4BasisNs / result.cachedBasisNs
+			          << std::setw(12) << std::scientific << result.maxError
+			          << std::defaultfloat << std::endl;
+		}
+	}
+	return 0;
+}
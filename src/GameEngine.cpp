@@ -1,11 +1,20 @@
+#include <chrono>
 #include <iostream>
 
 #include <glad/glad.h>
 
+#include "AssetImport/AssetLoader.h"
+#include "AssetImport/KTXFile.h"
 #include "Player/Camera.h"
 #include "GameEngine.h"
 #include "Utils/GameOptions.h"
+#include "Utils/JobSystem.h"
+#include "Utils/TransformSystem.h"
+#include "Rendering/MeshArena.h"
+#include "Rendering/RenderQueue.h"
 #include "Rendering/Scene.h"
+#include "Rendering/UniformBlocks.h"
+#include "Rendering/UniformRingBuffer.h"
 #include "Rendering/Window.h"
 // TODO: I shouldn't need to include these, but for some reason I do
 #include "Rendering/Skybox.h"
@@ -73,9 +82,35 @@ GameEngine::GameEngine(const std::string& options_file) :
 
 	// Set the void color
 	glClearColor(options.clearColor.r, options.clearColor.g, options.clearColor.b, 1.0f);
+
+	// Start the physics worker threads
+	jobSystem = std::make_unique<JobSystem>(options.physicsThreads);
+	transformSystem = std::make_shared<TransformSystem>();
+
+	// Per-object constants go through the render queue, so each frame's region of the
+	//   uniform buffer only holds the FrameUniforms block
+	uniformBuffer = std::make_unique<UniformRingBuffer>(sizeof(FrameUniforms));
+	renderQueue = std::make_unique<RenderQueue>();
+	// The arena's vertex array reads instance attributes from the render queue's buffer
+	const VertexFormat vertex_format =
+		options.packedVertices ? VertexFormat::PACKED : VertexFormat::FULL;
+	meshArena = std::make_shared<MeshArena>(vertex_format, renderQueue->GetBufferID());
+	// Asset workers check which compressed texture formats can be used, so find them first
+	KTXFile::QuerySupportedFormats();
+	assetLoader = std::make_unique<AssetLoader>(options.assetThreads,
+	                                            (size_t)options.assetUploadBudgetKb * 1024);
 }
 
 GameEngine::~GameEngine() {
+	StopPhysics();
+	// Stop loading before the scene goes away, since finished loads upload into it
+	assetLoader.reset();
+	// The renderer's GL objects must be deleted while the context still exists. The scene
+	//   goes first, since its meshes hold onto the mesh arena
+	scene.reset();
+	meshArena.reset();
+	renderQueue.reset();
+	uniformBuffer.reset();
 	// clean up all of GLFW's resources that were allocated
 	glfwTerminate();
 }
@@ -90,19 +125,51 @@ void GameEngine::SetupScene(const std::string& filename) {
 
 	scene = std::make_shared<Scene>(enable_shared_from_this::weak_from_this());
 	scene->LoadSceneFile(filename);
+
+	// Loading already ran the first physics update, so its transforms are the first
+	//   snapshot. The physics thread's clock is real time, and the inline one starts at 0
+	if (options.physicsThread) {
+		transformSystem->PublishSnapshot(glfwGetTime());
+		physicsRunning = true;
+		physicsThread = std::thread(&GameEngine::PhysicsThreadLoop, this);
+	}
+	else {
+		transformSystem->PublishSnapshot(physicsTime);
+	}
 }
 
 void GameEngine::RenderScene(double delta_time) {
 	// Clear the color & depth buffers 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	int run_this_frame = 0;
-	while (physicsTimer > options.physicsTimeStep) {
-		scene->UpdateScenePhysics(options.physicsTimeStep);
-		run_this_frame++;
-		physicsTimer -= options.physicsTimeStep;
+	double render_time;
+	if (options.physicsThread) {
+		// Snapshots are stamped with the time their step ends at, and are published before
+		//   then, so the current time always falls between the last two
+		render_time = glfwGetTime();
 	}
-	physicsTimer += delta_time;
-	
+	else {
+		// Count this frame's time BEFORE stepping, so the steps it covers run this frame
+		//   instead of the next one
+		physicsTimer += delta_time;
+		while (physicsTimer >= options.physicsTimeStep) {
+			physicsTime += options.physicsTimeStep;
+			StepPhysics(physicsTime);
+			physicsTimer -= options.physicsTimeStep;
+		}
+		// The leftover time hasn't been simulated, so draw that far past the step before
+		//   the last one. This lags by one step, but never has to guess ahead
+		render_time = physicsTime - options.physicsTimeStep + physicsTimer;
+	}
+	transformSystem->InterpolateSnapshots(render_time);
+
+	// Upload whatever the asset loader has finished, up to this frame's budget. Models
+	//   that replace the placeholder change size, so the static BVH has to be rebuilt
+	if (assetLoader->ProcessUploads() > 0) {
+		scene->RebuildStaticBVH();
+	}
+	scene->TrimAssetCaches();
+
+	uniformBuffer->BeginFrame();
 	scene->RenderScene(options.frameDelayMs);
 
 	// Swap OpenGL buffers
@@ -113,6 +180,51 @@ void GameEngine::RenderScene(double delta_time) {
 	if (options.showFramerate) {
 		std::cout << "Framerate: " << 1.0f / delta_time << std::endl;
 	}
+	if (options.showRenderStats) {
+		const RenderStats& stats = renderQueue->GetStats();
+		std::cout << "Render stats: " << stats.numDrawCalls << " draws (";
+		std::cout << stats.numDrawCommands << " meshes, ";
+		std::cout << stats.numInstances << " instances, ";
+		std::cout << stats.numCulled << " culled), binds: ";
+		std::cout << stats.numProgramBinds << " program, ";
+		std::cout << stats.numVertexArrayBinds << " vertex array, ";
+		std::cout << stats.numTextureBinds << " texture, ";
+		std::cout << stats.numSkippedBinds << " skipped" << std::endl;
+	}
+}
+
+void GameEngine::StopPhysics() {
+	if (physicsThread.joinable()) {
+		physicsRunning = false;
+		physicsThread.join();
+	}
+}
+
+void GameEngine::StepPhysics(const double step_time) {
+	scene->UpdateScenePhysics(options.physicsTimeStep);
+	transformSystem->PublishSnapshot(step_time);
+}
+
+void GameEngine::PhysicsThreadLoop() {
+	const double time_step = options.physicsTimeStep;
+	double step_time = glfwGetTime();
+	while (physicsRunning) {
+		// Each step is stamped with the time it ends at, and runs as soon as the previous
+		//   step's time arrives, so its results are ready before they're drawn
+		step_time += time_step;
+		StepPhysics(step_time);
+
+		const double current_time = glfwGetTime();
+		if (current_time - step_time > MAX_PHYSICS_LAG_STEPS * time_step) {
+			// Physics fell too far behind (i.e. a long spike). Skip the missed steps instead
+			//   of running them back to back, which would only make it fall further behind
+			step_time = current_time;
+		}
+		else if (current_time < step_time) {
+			const std::chrono::duration<double> wait_time(step_time - current_time);
+			std::this_thread::sleep_for(wait_time);
+		}
+	}
 }
 
 void GameEngine::InputMoveCamera(glm::vec2 motion) const {
@@ -171,6 +283,38 @@ std::shared_ptr<Scene> GameEngine::GetCurrentScene() const {
 	return scene;
 }
 
+JobSystem& GameEngine::GetJobSystem() const {
+	return *jobSystem;
+}
+
+const std::shared_ptr<TransformSystem>& GameEngine::GetTransformSystem() const {
+	return transformSystem;
+}
+
+UniformRingBuffer& GameEngine::GetUniformBuffer() const {
+	return *uniformBuffer;
+}
+
+RenderQueue& GameEngine::GetRenderQueue() const {
+	return *renderQueue;
+}
+
+const std::shared_ptr<MeshArena>& GameEngine::GetMeshArena() const {
+	return meshArena;
+}
+
+AssetLoader& GameEngine::GetAssetLoader() const {
+	return *assetLoader;
+}
+
+size_t GameEngine::GetModelCacheBudget() const {
+	return (size_t)options.modelCacheBudgetMb << 20;
+}
+
+size_t GameEngine::GetTextureCacheBudget() const {
+	return (size_t)options.textureCacheBudgetMb << 20;
+}
+
 void GameEngine::SetCurrentCamera(const std::shared_ptr<Camera> new_camera) {
 	cameraRef = new_camera;
 }
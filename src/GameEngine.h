@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include <glad/glad.h>
 #define GLFW_INCLUDE_NONE
@@ -9,9 +11,15 @@
 #include <glm/glm.hpp>
 
 #include "Utils/GameOptions.h"
+class AssetLoader;
 class Window;
 class Scene;
 class Camera;
+class JobSystem;
+class MeshArena;
+class RenderQueue;
+class TransformSystem;
+class UniformRingBuffer;
 
 ///
 /// Handles rendering frames, calling physics updates, managing the
@@ -25,8 +33,12 @@ public:
 	GameEngine(const std::string& options_file);
 	~GameEngine();
 
+	// Load a scene, then start the physics thread if it's enabled
 	void SetupScene(const std::string& filename);
 	void RenderScene(double delta_time);
+	// Stop and join the physics thread, if it's running. Must be called before the last
+	//   reference to the engine is released, since physics steps hold references to it
+	void StopPhysics();
 
 	/* ----- Input events (from the mainWindow) ----- */
 	void InputMoveCamera(glm::vec2 motion) const;
@@ -40,6 +52,16 @@ public:
 	const float GetPhysicsTimeStep() const;
 	std::string GetDefaultModelPath() const;
 	std::shared_ptr<Scene> GetCurrentScene() const;
+	JobSystem& GetJobSystem() const;
+	const std::shared_ptr<TransformSystem>& GetTransformSystem() const;
+	UniformRingBuffer& GetUniformBuffer() const;
+	RenderQueue& GetRenderQueue() const;
+	const std::shared_ptr<MeshArena>& GetMeshArena() const;
+	AssetLoader& GetAssetLoader() const;
+	// Sizes (in bytes) that the scene's model & texture caches can grow to before unused
+	//   assets are freed
+	size_t GetModelCacheBudget() const;
+	size_t GetTextureCacheBudget() const;
 
 	/* ----- Setters ----- */
 	void SetCurrentCamera(const std::shared_ptr<Camera> new_camera);
@@ -52,17 +74,46 @@ private:
 	// The Scene should be kept as a shared ptr since some SceneObjects will query
 	//   the GameEngine to get references to it
 	std::shared_ptr<Scene> scene;
+	// Runs independent parts of the physics update in parallel
+	std::unique_ptr<JobSystem> jobSystem;
+	// Transforms of every SceneObject. Shared, since each SceneObject keeps a reference so
+	//   that it can release its transform node when destroyed
+	std::shared_ptr<TransformSystem> transformSystem;
+	// Per-frame shader constants, rewritten every frame
+	std::unique_ptr<UniformRingBuffer> uniformBuffer;
+	// Collects, sorts, and draws every ModelObject each frame
+	std::unique_ptr<RenderQueue> renderQueue;
+	// Vertex & index data of every loaded mesh. Shared, since each StaticMesh keeps a
+	//   reference so that it can release its space when destroyed
+	std::shared_ptr<MeshArena> meshArena;
+	// Reads model & texture files in the background, then uploads them a little at a
+	//   time each frame
+	std::unique_ptr<AssetLoader> assetLoader;
 
 	/* ----- Objects that the GameEngine references, but have lifetimes controlled by
 	other objects ----- */
 	std::weak_ptr<Camera> cameraRef;
 
 	/* ----- Keyboard Inputs ----- */
-	// Keep track of which keys are currently being pressed
-	bool keysPressed[GLFW_KEY_LAST] = {false};
+	// Keep track of which keys are currently being pressed. Atomic, since they're set by
+	//   the window's callbacks and read by physics, which may be on another thread
+	std::atomic<bool> keysPressed[GLFW_KEY_LAST] = {};
 
-	// Counter for keeping track of physics updates
-	float physicsTimer = 0.0f;
+	/* ----- Physics timing ----- */
+	// Run one physics step, then publish the new transforms for rendering. 'step_time' is
+	//   the time the step ends at, on the same clock that frames are interpolated with
+	void StepPhysics(const double step_time);
+	// Body of the physics thread. Steps at a fixed rate until StopPhysics is called
+	void PhysicsThreadLoop();
+	// Most steps the physics thread will fall behind before it gives up on catching up
+	static constexpr int MAX_PHYSICS_LAG_STEPS = 5;
+	// Time that hasn't been simulated yet, when physics runs on the render thread
+	double physicsTimer = 0.0;
+	// Simulated time at the end of the last physics step, when physics runs on the render
+	//   thread
+	double physicsTime = 0.0;
+	std::thread physicsThread;
+	std::atomic<bool> physicsRunning{ false };
 	
 	GameOptions options;
 
@@ -0,0 +1,64 @@
+#include <cmath>
+#include <cassert>
+
+#include "ChainKinematics.h"
+
+template <int N, typename Scalar>
+constexpr int ChainKinematics<N, Scalar>::NUM_SEGMENTS;
+
+template <int N, typename Scalar>
+Eigen::Vector2d ChainKinematics<N, Scalar>::Evaluate(const Vector& theta) const {
+	const size_t num_links = linkData.GetNumLinks();
+	assert((size_t)theta.rows() == num_links);
+	linkData.SetAngles(theta);
+	const Scalar* offset = linkData.GetField(LinkData::OFFSET);
+	const Scalar* cos_theta = linkData.GetField(LinkData::COS);
+	const Scalar* sin_theta = linkData.GetField(LinkData::SIN);
+	Scalar* suffix_x = linkData.GetField(LinkData::SUFFIX_X);
+	Scalar* suffix_y = linkData.GetField(LinkData::SUFFIX_Y);
+
+	// Walk down the chain, writing each link's segment (in chain space) into the
+	//   suffix buffer. Segment i is link i's offset, rotated by the total angle of
+	//   links 0 -> i-1. That rotation is built up one link at a time from the cos & sin
+	//   of each angle, so no more trig is needed. The first offset is never rotated
+	Scalar cos_phi = 1.0;
+	Scalar sin_phi = 0.0;
+	for (size_t i = 0; i < num_links; ++i) {
+		suffix_x[i] = offset[i] * cos_phi;
+		suffix_y[i] = offset[i] * sin_phi;
+		const Scalar next_cos = cos_phi * cos_theta[i] - sin_phi * sin_theta[i];
+		sin_phi = sin_phi * cos_theta[i] + cos_phi * sin_theta[i];
+		cos_phi = next_cos;
+	}
+	// The final segment is the end effector, rotated by the angle of the whole chain
+	const Scalar r_x = (Scalar)endEffector.x();
+	const Scalar r_y = (Scalar)endEffector.y();
+	suffix_x[num_links] = cos_phi * r_x - sin_phi * r_y;
+	suffix_y[num_links] = sin_phi * r_x + cos_phi * r_y;
+
+	// Accumulate from the end effector back to the root, so that row k holds the sum
+	//   of segments k -> n
+	for (int i = (int)num_links - 1; i >= 0; --i) {
+		suffix_x[i] += suffix_x[i + 1];
+		suffix_y[i] += suffix_y[i + 1];
+	}
+
+	return Eigen::Vector2d(suffix_x[0], suffix_y[0]);
+}
+
+// Instantiate every chain size that ChainSolver::Create can choose, in both precisions
+//   that IKScalar can choose
+template class ChainKinematics<2, float>;
+template class ChainKinematics<3, float>;
+template class ChainKinematics<4, float>;
+template class ChainKinematics<5, float>;
+template class ChainKinematics<6, float>;
+template class ChainKinematics<7, float>;
+template class ChainKinematics<Eigen::Dynamic, float>;
+template class ChainKinematics<2, double>;
+template class ChainKinematics<3, double>;
+template class ChainKinematics<4, double>;
+template class ChainKinematics<5, double>;
+template class ChainKinematics<6, double>;
+template class ChainKinematics<7, double>;
+template class ChainKinematics<Eigen::Dynamic, double>;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "ChainLinkData.h"
+
+///
+/// Side-effect-free forward kinematics for a planar IK chain. Takes the link offsets
+/// and joint angles as plain data and computes the end effector position p, leaving the
+/// intermediate values that p's derivatives are built from in the chain's link data.
+/// Never touches the scene graph, so the optimizers can evaluate as many trial poses as
+/// they want without dirtying any Links.
+///
+/// Uses the same 2D 'J' space as IKChain, where each link is J_i = T(offset_i) * R(theta_i):
+///   p = J_0 * J_1 * ... * J_(n-1) * r
+/// Expanding the product, p is the sum of each link's offset rotated by the total angle
+///   of all previous links, plus r rotated by the total angle of the whole chain. Taking
+///   suffix sums of those segments gives every derivative in O(1), since rotating a
+///   segment by theta_j only affects the segments after joint j:
+///   - dp/dtheta_j is suffix sum j + 1 (joint j -> end effector) rotated by 90 degrees
+///   - d2p/(dtheta_j * dtheta_k) is the negated suffix sum after the outermost of j and k
+///
+/// N is the number of links. If N is known at compile time, every buffer is a fixed-size
+///   Eigen type and evaluation never touches the heap. Eigen::Dynamic works for any size.
+///   Scalar is the precision of the link data that the FK runs on (see IKScalar).
+///
+template <int N, typename Scalar = IKScalar>
+class ChainKinematics {
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	// Number of chain segments: one per link, plus the end effector
+	static constexpr int NUM_SEGMENTS = ChainLinkData<N, Scalar>::NUM_ROWS;
+
+	typedef Eigen::Matrix<double, N, 1> Vector;
+	typedef ChainLinkData<N, Scalar> LinkData;
+
+	ChainKinematics() = default;
+	~ChainKinematics() = default;
+
+	// Find the end effector position for the given angles. Afterward, the link data holds
+	//   the angles, their cos & sin, and the suffix sums of the chain segments. Costs O(n)
+	Eigen::Vector2d Evaluate(const Vector& theta) const;
+
+	/* ----- Getters ----- */
+	size_t GetNumLinks() const { return linkData.GetNumLinks(); }
+	double GetLinkOffset(const size_t link_idx) const {
+		return (double)linkData.GetField(LinkData::OFFSET)[link_idx];
+	}
+	const Eigen::Vector2d& GetEndEffector() const { return endEffector; }
+	// Link data from the most recent Evaluate
+	const LinkData& GetLinkData() const { return linkData; }
+
+	/* ----- Setters ----- */
+	// Offset of each link's root along the x axis of the previous link. For fixed-size
+	//   chains, there must be exactly N offsets
+	void SetLinkOffsets(const std::vector<double>& offsets) { linkData.SetLinkOffsets(offsets); }
+	// Location of the end effector in the local space of the final link
+	void SetEndEffector(const Eigen::Vector2d& r) { endEffector = r; }
+
+private:
+	// Offsets, angles and segment suffix sums of the chain, all in one contiguous block.
+	//   Evaluate writes its intermediate values here, so that repeated evaluations don't
+	//   need any other scratch space
+	mutable LinkData linkData;
+	Eigen::Vector2d endEffector = Eigen::Vector2d(0.5, 0.0);
+};
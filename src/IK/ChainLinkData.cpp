@@ -0,0 +1,62 @@
+#include <cassert>
+#include <cmath>
+
+#include "ChainLinkData.h"
+
+template <int N, typename Scalar>
+constexpr int ChainLinkData<N, Scalar>::NUM_ROWS;
+
+template <int N, typename Scalar>
+ChainLinkData<N, Scalar>::ChainLinkData() :
+	numLinks((N == Eigen::Dynamic) ? 0 : N)
+{
+	block.setZero(numLinks + 1, NUM_FIELDS);
+	block.col(COS).setOnes();
+}
+
+template <int N, typename Scalar>
+void ChainLinkData<N, Scalar>::SetAngles(const Eigen::Matrix<double, N, 1>& new_angles) {
+	assert((size_t)new_angles.rows() == numLinks);
+	Scalar* angle = GetField(ANGLE);
+	Scalar* cos_angle = GetField(COS);
+	Scalar* sin_angle = GetField(SIN);
+	for (size_t i = 0; i < numLinks; ++i) {
+		angle[i] = (Scalar)new_angles(i);
+		cos_angle[i] = std::cos(angle[i]);
+		sin_angle[i] = std::sin(angle[i]);
+	}
+}
+
+template <int N, typename Scalar>
+std::vector<double> ChainLinkData<N, Scalar>::GetLinkOffsets() const {
+	const Scalar* offset = GetField(OFFSET);
+	return std::vector<double>(offset, offset + numLinks);
+}
+
+template <int N, typename Scalar>
+void ChainLinkData<N, Scalar>::SetLinkOffsets(const std::vector<double>& offsets) {
+	assert(N == Eigen::Dynamic || offsets.size() == (size_t)N);
+	numLinks = offsets.size();
+	block.setZero(numLinks + 1, NUM_FIELDS);
+	block.col(COS).setOnes();
+	for (size_t i = 0; i < numLinks; ++i) {
+		block(i, OFFSET) = (Scalar)offsets[i];
+	}
+}
+
+// Instantiate every chain size that ChainSolver::Create can choose, in both precisions
+//   that IKScalar can choose
+template class ChainLinkData<2, float>;
+template class ChainLinkData<3, float>;
+template class ChainLinkData<4, float>;
+template class ChainLinkData<5, float>;
+template class ChainLinkData<6, float>;
+template class ChainLinkData<7, float>;
+template class ChainLinkData<Eigen::Dynamic, float>;
+template class ChainLinkData<2, double>;
+template class ChainLinkData<3, double>;
+template class ChainLinkData<4, double>;
+template class ChainLinkData<5, double>;
+template class ChainLinkData<6, double>;
+template class ChainLinkData<7, double>;
+template class ChainLinkData<Eigen::Dynamic, double>;
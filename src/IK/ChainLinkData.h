@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+// Precision of every chain's link data, and so of the forward kinematics that run on it.
+//   Define SPIDER_IK_FLOAT to store it as floats, which halves its size and matches the
+//   precision of the render transforms. The optimizers keep their own state (angles,
+//   gradient & Hessian) in double either way
+#ifdef SPIDER_IK_FLOAT
+typedef float IKScalar;
+#else
+typedef double IKScalar;
+#endif
+
+///
+/// Per-link data for a planar IK chain with N links (or Eigen::Dynamic for any number),
+/// stored as a structure-of-arrays in one contiguous block. Each field is a column of the
+/// block, so the per-link loops over it run over contiguous memory and can be vectorized.
+/// With a fixed N, the whole block is a few cache lines and never touches the heap.
+///
+/// Every field has a row for each link, plus one more for the end effector. The link-only
+/// fields (offset, angle, cos & sin) leave that row at 0 offset and 0 angle.
+///
+template <int N, typename Scalar = IKScalar>
+class ChainLinkData {
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	// Row count of every field: one per link, plus the end effector
+	static constexpr int NUM_ROWS = (N == Eigen::Dynamic) ? Eigen::Dynamic : N + 1;
+
+	// Columns of the block
+	enum Field {
+		// Offset of each link's root along the x axis of the previous link
+		OFFSET,
+		// Angle of each link relative to the previous link, and its cos & sin
+		ANGLE,
+		COS,
+		SIN,
+		// Suffix sums of the chain-space segments, written by ChainKinematics. Row k is
+		//   the vector from joint k to the end effector, and row 0 is the end effector itself
+		SUFFIX_X,
+		SUFFIX_Y,
+		NUM_FIELDS
+	};
+
+	ChainLinkData();
+	~ChainLinkData() = default;
+
+	// Store each angle, along with its cos & sin. Independent per link, so the loop vectorizes
+	void SetAngles(const Eigen::Matrix<double, N, 1>& new_angles);
+
+	/* ----- Getters ----- */
+	size_t GetNumLinks() const { return numLinks; }
+	std::vector<double> GetLinkOffsets() const;
+	// First row of the given field
+	Scalar* GetField(const Field field) { return block.col(field).data(); }
+	const Scalar* GetField(const Field field) const { return block.col(field).data(); }
+
+	/* ----- Setters ----- */
+	// Sets the number of links as well. For fixed-size chains, there must be exactly N
+	//   offsets. Every angle is reset to 0
+	void SetLinkOffsets(const std::vector<double>& offsets);
+
+private:
+	size_t numLinks;
+	Eigen::Matrix<Scalar, NUM_ROWS, NUM_FIELDS> block;
+};
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <iostream>
+
+#include "ChainSolver.h"
+#include "OptimizerAnalytic.h"
+#include "OptimizerCCD.h"
+#include "OptimizerFABRIK.h"
+#include "OptimizerNM.h"
+
+constexpr size_t ChainSolver::MIN_FIXED_LINKS;
+constexpr size_t ChainSolver::MAX_FIXED_LINKS;
+
+void ChainSolver::WrapAngles(Eigen::VectorXd& angles) {
+	// Wrap each angle from -pi to pi
+	size_t num_angles = angles.rows();
+	double pi = 3.1415926535;
+	for (size_t i = 0; i < num_angles; ++i) {
+		while (angles(i) > pi) {
+			angles(i) -= 2.0 * pi;
+		}
+		while (angles(i) < -1.0 * pi) {
+			angles(i) += 2.0 * pi;
+		}
+	}
+}
+
+namespace {
+// Make a ChainSolver for N links that runs the given method. Analytic is handled by the
+//   caller, since it only exists for N = 2
+template <int N>
+std::unique_ptr<ChainSolver> MakeSolver(const size_t num_links,
+                                        const ChainSolver::Method method) {
+	std::unique_ptr<Optimizer<N> > optimizer;
+	switch (method) {
+	case ChainSolver::Method::FABRIK:
+		optimizer = std::make_unique<OptimizerFABRIK<N> >(num_links);
+		break;
+	case ChainSolver::Method::CCD:
+		optimizer = std::make_unique<OptimizerCCD<N> >(num_links);
+		break;
+	default:
+		optimizer = std::make_unique<OptimizerNM<N> >(num_links);
+		break;
+	}
+	return std::make_unique<ChainSolverN<N> >(num_links, std::move(optimizer));
+}
+} // namespace
+
+std::unique_ptr<ChainSolver> ChainSolver::Create(const size_t num_links, Method method,
+                                                 const bool allow_fixed_size) {
+	if (method == Method::Analytic && (num_links != 2 || !allow_fixed_size)) {
+		std::cerr << "ERROR: The analytic IK solver only supports fixed-size 2-link chains, "
+			<< "using newton's method instead" << std::endl;
+		method = Method::Newton;
+	}
+	if (allow_fixed_size) {
+		switch (num_links) {
+		case 2:
+			if (method == Method::Auto || method == Method::Analytic) {
+				return std::make_unique<ChainSolverN<2> >(num_links,
+					std::make_unique<OptimizerAnalytic>());
+			}
+			return MakeSolver<2>(num_links, method);
+		case 3: return MakeSolver<3>(num_links, method);
+		case 4: return MakeSolver<4>(num_links, method);
+		case 5: return MakeSolver<5>(num_links, method);
+		case 6: return MakeSolver<6>(num_links, method);
+		case 7: return MakeSolver<7>(num_links, method);
+		default: break;
+		}
+	}
+	return MakeSolver<Eigen::Dynamic>(num_links, method);
+}
+
+ChainSolver::Method ChainSolver::ParseMethod(const std::string& name) {
+	if (name == "auto") return Method::Auto;
+	if (name == "newton") return Method::Newton;
+	if (name == "analytic") return Method::Analytic;
+	if (name == "fabrik") return Method::FABRIK;
+	if (name == "ccd") return Method::CCD;
+	std::cerr << "ERROR: Unknown IK solver '" << name << "', using 'auto' instead" << std::endl;
+	return Method::Auto;
+}
+
+void ChainSolver::Solve(const Eigen::Vector2d& target, Eigen::VectorXd& angles) {
+	auto start = std::chrono::steady_clock::now();
+
+	// If the target hasn't moved and the chain is still in the cached pose, the previous
+	//   result is still the answer
+	lastStats.cacheHit = hasCache && (target - cachedTarget).norm() < targetEpsilon &&
+		angles.rows() == cachedAngles.rows() && angles == cachedAngles;
+	if (lastStats.cacheHit) {
+		lastStats.iterations = 0;
+		++numCacheHits;
+	}
+	else {
+		lastStats.iterations = Optimize(target, angles);
+		++numCacheMisses;
+		hasCache = true;
+		cachedTarget = target;
+		cachedAngles = angles;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	lastStats.timeUs = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+template <int N>
+ChainSolverN<N>::ChainSolverN(const size_t num_links,
+                              std::unique_ptr<Optimizer<N> > new_optimizer) :
+	optimizer(std::move(new_optimizer))
+{
+	anglesWork.setZero(num_links);
+}
+
+template <int N>
+int ChainSolverN<N>::Optimize(const Eigen::Vector2d& target, Eigen::VectorXd& angles) {
+	objectiveFunc.SetTarget(target);
+
+	// Every optimizer converges on its own, so there's no need for a pre-pass or for
+	//   comparing results afterward. Note: it works on a copy in this solver's vector type
+	anglesWork = angles;
+	optimizer->optimize(objectiveFunc, anglesWork);
+	angles = anglesWork;
+
+	WrapAngles(angles);
+	return optimizer->getIter();
+}
+
+template <int N>
+void ChainSolverN<N>::SetChainGeometry(const std::vector<double>& link_offsets,
+                                       const Eigen::Vector2d& r) {
+	objectiveFunc.SetChainGeometry(link_offsets, r);
+	ClearCache();
+}
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class ChainSolverN<2>;
+template class ChainSolverN<3>;
+template class ChainSolverN<4>;
+template class ChainSolverN<5>;
+template class ChainSolverN<6>;
+template class ChainSolverN<7>;
+template class ChainSolverN<Eigen::Dynamic>;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "LinkObjective.h"
+#include "Optimizer.h"
+
+///
+/// Solves the IK problem for a single chain, independent of the scene graph, using
+/// damped newton's method by default. Used by IKChain for chains that aren't solved in a batch,
+/// and by the benchmarks as the per-chain reference
+///
+/// Use Create() to get a solver that's specialized for the chain's size and chosen method
+///
+class ChainSolver {
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	// Profiling info for a single solve
+	struct SolveStats {
+		// Number of optimizer iterations
+		int iterations = 0;
+		// Wall-clock time spent solving, in microseconds
+		double timeUs = 0.0;
+		// Was the optimizer skipped, since the target hadn't moved?
+		bool cacheHit = false;
+	};
+
+	// Which optimizer a solver runs
+	enum class Method {
+		// Analytic for 2-link chains, damped newton's method for everything else
+		Auto,
+		Newton,
+		// Only valid for 2-link chains
+		Analytic,
+		// Approximate: neither one minimizes the objective exactly
+		FABRIK,
+		CCD
+	};
+
+	// Range of chain sizes that get a fixed-size solver. Must match the explicit
+	//   instantiations in the IK source files
+	static constexpr size_t MIN_FIXED_LINKS = 2;
+	static constexpr size_t MAX_FIXED_LINKS = 7;
+
+	// Wrap angles to the range [-pi, pi]
+	static void WrapAngles(Eigen::VectorXd& angles);
+	// Make a solver for a chain with num_links links. Sizes between MIN_FIXED_LINKS and
+	//   MAX_FIXED_LINKS use compile-time sized matrices and never allocate while solving.
+	//   Any other size (or allow_fixed_size = false) falls back to dynamic matrices.
+	//   See Method for which optimizer Auto picks
+	static std::unique_ptr<ChainSolver> Create(const size_t num_links,
+	                                           const Method method = Method::Auto,
+	                                           const bool allow_fixed_size = true);
+	// Get the method with the given name ("auto", "newton", "analytic", "fabrik" or "ccd").
+	//   Unknown names print an error and return Auto
+	static Method ParseMethod(const std::string& name);
+
+	ChainSolver() {};
+	virtual ~ChainSolver() {};
+
+	// Find the angles that best reach the target. 'angles' is used as the starting point
+	//   for the optimization (so passing in the previous result warm-starts the solve), and
+	//   is overwritten with the (wrapped) result. If 'angles' is the previous result and the
+	//   target moved less than the target epsilon since then, the optimizer is skipped
+	void Solve(const Eigen::Vector2d& target, Eigen::VectorXd& angles);
+	// Forget the previous result, so that the next Solve always runs the optimizer
+	void ClearCache() { hasCache = false; }
+
+	/* ----- Getters ----- */
+	virtual bool IsFixedSize() const = 0;
+	const SolveStats& GetLastStats() const { return lastStats; }
+	// Number of solves that were skipped/run since the solver was created
+	size_t GetNumCacheHits() const { return numCacheHits; }
+	size_t GetNumCacheMisses() const { return numCacheMisses; }
+
+	/* ----- Setters ----- */
+	virtual void SetChainGeometry(const std::vector<double>& link_offsets,
+	                              const Eigen::Vector2d& r) = 0;
+	// Distance the target must move (in J-space) before the chain is solved again
+	void SetTargetEpsilon(const double epsilon) { targetEpsilon = epsilon; }
+
+protected:
+	// Run the optimizer from 'angles' toward the target, overwriting 'angles' with the
+	//   (wrapped) result. Returns the number of iterations taken
+	virtual int Optimize(const Eigen::Vector2d& target, Eigen::VectorXd& angles) = 0;
+
+private:
+	// Profiling info from the most recent call to Solve
+	SolveStats lastStats;
+
+	/* ----- Result cache ----- */
+	double targetEpsilon = 0.0;
+	bool hasCache = false;
+	// Target and result of the most recent solve that ran the optimizer
+	Eigen::Vector2d cachedTarget;
+	Eigen::VectorXd cachedAngles;
+	size_t numCacheHits = 0;
+	size_t numCacheMisses = 0;
+};
+
+///
+/// ChainSolver for a chain with N links (or Eigen::Dynamic for any number), using any
+/// Optimizer that works on chains of that size
+///
+template <int N>
+class ChainSolverN : public ChainSolver {
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	typedef typename LinkObjective<N>::Vector Vector;
+
+	ChainSolverN(const size_t num_links, std::unique_ptr<Optimizer<N> > new_optimizer);
+	~ChainSolverN() = default;
+
+	// Inherited from ChainSolver
+	virtual bool IsFixedSize() const override { return N != Eigen::Dynamic; }
+	virtual void SetChainGeometry(const std::vector<double>& link_offsets,
+	                              const Eigen::Vector2d& r) override;
+
+	/* ----- Getters ----- */
+	const LinkObjective<N>& GetObjective() const { return objectiveFunc; }
+
+protected:
+	// Inherited from ChainSolver
+	virtual int Optimize(const Eigen::Vector2d& target, Eigen::VectorXd& angles) override;
+
+private:
+	// Objects responsible for solving the IK problem
+	std::unique_ptr<Optimizer<N> > optimizer;
+	LinkObjective<N> objectiveFunc;
+	// Working copy of the angles. Kept as a member so dynamic-size chains don't reallocate
+	Vector anglesWork;
+};
@@ -7,38 +7,21 @@
 #include <glm/gtc/constants.hpp>
 
 #include "IKChain.h"
+#include "ChainSolver.h"
 #include "Link.h"
-#include "OptimizerGDLS.h"
-#include "OptimizerNM.h"
 #include "../Rendering/SceneObject.h"
 
 IKChain::IKChain(std::weak_ptr<GameEngine> engine, const std::string& name,
-	const size_t num_links, const bool render_links) :
+	const size_t num_links, const bool render_links, const ChainSolver::Method ik_method) :
 	SceneObject(engine, name),
-	optimizerGDLS(numLinks),
-	optimizerNM(numLinks),
 	numLinks(num_links),
-	renderLinks(render_links) {
+	renderLinks(render_links),
+	solver(ChainSolver::Create(num_links, ik_method)) {
 	// TODO: endEffectorPos should == the linkLength of the final link in the chain: [len, 0]
 	//   Right now, this is hardcoded to 0.5, so keep the same hardcoding here
 	J_endEffectorPos << 0.5, 0.0, 1.0;
 }
 
-// TODO: move this
-void IKChain::WrapAngles(Eigen::VectorXd& angles) {
-	// Wrap each angle from -pi to pi
-	size_t num_angles = angles.rows();
-	double pi = 3.1415926535;
-	for (size_t i = 0; i < num_angles; ++i) {
-		while (angles(i) > pi) {
-			angles(i) -= 2.0 * pi;
-		}
-		while (angles(i) < -1.0 * pi) {
-			angles(i) += 2.0 * pi;
-		}
-	}
-}
-
 void IKChain::BeginPlay() {
 	// Find this chain's target point. The target should be attached to the spider
 	//   character, which is the Chain's parent object
@@ -51,9 +34,6 @@ void IKChain::BeginPlay() {
 	linkRoot = std::make_shared<SceneObject>(engineRef, objectName + "link_root");
 	AddChildObject(linkRoot);
 
-	// Get a shared ptr to self (SceneObject), then cast to IKChain for objectiveFunction
-	objectiveFunc.SetChainRef(std::dynamic_pointer_cast<IKChain>(shared_from_this()));
-	
 	// Create the links in the chain
 	// TODO: remove hardcoding
 	// The first link in the chain should be shorter than the others
@@ -65,6 +45,7 @@ void IKChain::BeginPlay() {
 	}
 
 	// Note: this must be done in beginplay, since weak_from_this is called in AddChildObject
+	std::vector<double> offsets;
 	for (size_t i = 0; i < numLinks; ++i) {
 		std::string link_name = objectName + "_link_" + std::to_string(i);
 		
@@ -83,7 +64,12 @@ void IKChain::BeginPlay() {
 			allLinks.back()->AddChildObject(new_link);
 		}
 		allLinks.emplace_back(new_link);
+		offsets.emplace_back(link_offset);
 	}
+	linkData.SetLinkOffsets(offsets);
+	// Give the solver its own copy of the chain's layout, so that it can evaluate poses
+	//   without updating the links
+	solver->SetChainGeometry(offsets, J_endEffectorPos.head<2>());
 
 	// Initialize the angles with some hardcoded values. Used as a starting point for optimizer
 	J_linkAngles = Eigen::VectorXd::Zero(numLinks);
@@ -100,38 +86,20 @@ void IKChain::BeginPlay() {
 }
 
 void IKChain::PhysicsUpdate(const float delta_time) {
-	// Get the world-space position of the target
-	glm::vec4 target_loc = target.lock()->GetWorldTransformMtx()[3];
-	// Get the local-space position of the target
-	target_loc = glm::inverse(modelMtx) * target_loc;
-	// Rotate the Chain to face the target location
-	// TODO: Figure out why this -1.0f is necessary
-	float rot_angle = -1.0f * atan2(target_loc.z, target_loc.x);
-	if (abs(rot_angle) < glm::radians(70.0)) {
-		linkRoot->SetRelativeRotation(glm::vec3(0.0f, rot_angle, 0.0f));
+	// If another object (i.e. a batch solver) is responsible for this chain's angles,
+	//   only propagate the transforms
+	if (!solvedExternally) {
+		// Solve in place on the chain's own angles, so that no temporary vector is needed.
+		//   This also warm-starts the solver from the previous tick's result, and lets it
+		//   skip the solve entirely if the target hasn't moved
+		Eigen::Vector2d x = AimAtTarget();
+		solver->Solve(x, J_linkAngles);
+		// A cache hit leaves the angles as they were, so the links are already posed
+		if (!solver->GetLastStats().cacheHit) {
+			UpdateLinkAngles();
+		}
 	}
 
-	// Set up the local-space target for the objective evaluation
-	Eigen::Vector2d x(target_loc.x, target_loc.y);
-	objectiveFunc.SetTarget(x);
-
-	// Perform GLDS optimization (note: chain angles are updated in the optimizer)
-	Eigen::VectorXd anglesGLDS = GetLinkAngles();
-	optimizerGDLS.optimize(objectiveFunc, anglesGLDS);
-
-	// Perform newton's method from where GLDS left off
-	Eigen::VectorXd anglesNM = anglesGLDS;
-	optimizerNM.optimize(objectiveFunc, anglesNM);
-
-	// Check if newton's method improved the result
-	Eigen::VectorXd angles = (objectiveFunc.evalObjective(anglesNM) < objectiveFunc.evalObjective(anglesGLDS)) ?
-		anglesNM : anglesGLDS;
-
-	// Wrap the angles and update the chain one final time
-	// TODO: just put the function here
-	WrapAngles(angles);
-	SetLinkAngles(angles);
-
 	SceneObject::PhysicsUpdate(delta_time);
 }
 
@@ -144,6 +112,22 @@ void IKChain::Render(const std::shared_ptr<ShaderProgram> shader) const {
 	}
 }
 
+Eigen::Vector2d IKChain::AimAtTarget() {
+	// Get the world-space position of the target
+	glm::vec4 target_loc = target.lock()->GetWorldTransformMtx()[3];
+	// Get the local-space position of the target
+	target_loc = glm::inverse(GetWorldTransformMtx()) * target_loc;
+	// Rotate the Chain to face the target location
+	// TODO: Figure out why this -1.0f is necessary
+	float rot_angle = -1.0f * atan2(target_loc.z, target_loc.x);
+	if (abs(rot_angle) < glm::radians(70.0)) {
+		linkRoot->SetRelativeRotation(glm::vec3(0.0f, rot_angle, 0.0f));
+	}
+
+	// Return the local-space target for the objective evaluation
+	return Eigen::Vector2d(target_loc.x, target_loc.y);
+}
+
 Eigen::Vector3d IKChain::GetEndEffectorPos() const {
 	return J_endEffectorPos;
 }
@@ -152,29 +136,32 @@ size_t IKChain::GetNumLinks() const {
 	return allLinks.size();;
 }
 
-const Eigen::Matrix3d& IKChain::GetJMatrix(size_t link_idx, size_t derivative) const {
-	assert(derivative <= 2);
-	if (derivative == 0) {
-		return allLinks.at(link_idx)->GetJ();
-	}
-	else if (derivative == 1) {
-		return allLinks.at(link_idx)->GetJPrime();
-	}
-	else if (derivative == 2) {
-		return allLinks.at(link_idx)->GetJ2Prime();
-	}
-	else {
-		std::cerr << "Error: Accessing invalid link matrix derivative!" << std::endl;
-		return Eigen::Matrix3d::Identity();
-	}
-}
-
 Eigen::VectorXd IKChain::GetLinkAngles() const {
 	return J_linkAngles;
 }
 
+std::vector<double> IKChain::GetLinkOffsets() const {
+	return linkData.GetLinkOffsets();
+}
+
+const ChainSolver& IKChain::GetSolver() const {
+	return *solver;
+}
+
 void IKChain::SetEndEffector(double x, double y){
 	J_endEffectorPos << x, y, 1.0;
+	// The links don't exist until BeginPlay, which passes the geometry along itself
+	if (linkData.GetNumLinks() > 0) {
+		solver->SetChainGeometry(linkData.GetLinkOffsets(), J_endEffectorPos.head<2>());
+	}
+}
+
+void IKChain::SetSolvedExternally(const bool is_external) {
+	solvedExternally = is_external;
+}
+
+void IKChain::SetTargetEpsilon(const double epsilon) {
+	solver->SetTargetEpsilon(epsilon);
 }
 
 void IKChain::SetLinkAngles(const Eigen::VectorXd& new_angles) {
@@ -187,7 +174,10 @@ void IKChain::SetLinkAngles(const Eigen::VectorXd& new_angles) {
 // PRIVATE FUNCTIONS
 
 void IKChain::UpdateLinkAngles() {
+	linkData.SetAngles(J_linkAngles);
+	const IKScalar* cos_angle = linkData.GetField(ChainLinkData<Eigen::Dynamic>::COS);
+	const IKScalar* sin_angle = linkData.GetField(ChainLinkData<Eigen::Dynamic>::SIN);
 	for (size_t i = 0; i < allLinks.size(); ++i) {
-		allLinks.at(i)->SetLinkAngle(J_linkAngles(i));
+		allLinks[i]->SetLinkRotation((float)cos_angle[i], (float)sin_angle[i]);
 	}
 }
\ No newline at end of file
@@ -6,9 +6,8 @@
 #include <eigen-3.4.0/Eigen/Dense>
 
 #include "../Rendering/SceneObject.h"
-#include "LinkObjective.h"
-#include "OptimizerGDLS.h"
-#include "OptimizerNM.h"
+#include "ChainLinkData.h"
+#include "ChainSolver.h"
 class Link;
 class GameEngine;
 class ShaderProgram;
@@ -21,11 +20,10 @@ class ShaderProgram;
 class IKChain : public SceneObject {
 public:
 	EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
-	// Wrap angles to the range [-pi, pi]
-	static void WrapAngles(Eigen::VectorXd& angles);
 
 	IKChain(std::weak_ptr<GameEngine> engine, const std::string& name,
-		const size_t num_links, const bool render_links);
+		const size_t num_links, const bool render_links,
+		const ChainSolver::Method ik_method = ChainSolver::Method::Auto);
 	~IKChain() = default;
 
 	// Inherited from SceneObject
@@ -33,41 +31,55 @@ public:
 	virtual void PhysicsUpdate(const float delta_time);
 	virtual void Render(const std::shared_ptr<ShaderProgram> shader) const;
 
+	// Rotate the chain (about its y axis) to face the target, then return the target's
+	//   location in J-space
+	Eigen::Vector2d AimAtTarget();
+
 	/* ----- Getters ----- */
 	Eigen::Vector3d GetEndEffectorPos() const;
 	size_t GetNumLinks() const;
-	const Eigen::Matrix3d& GetJMatrix(size_t link_idx, size_t derivative) const;
 	Eigen::VectorXd GetLinkAngles() const;
+	std::vector<double> GetLinkOffsets() const;
+	// This chain's own solver, for profiling info & cache counters. Unused if the chain is
+	//   solved externally
+	const ChainSolver& GetSolver() const;
 
 	/* ----- Setters ----- */
 	void SetEndEffector(double x, double y);
+	// If true, this chain won't solve its own IK during PhysicsUpdate. Whichever object
+	//   sets this is responsible for aiming the chain and setting its angles
+	void SetSolvedExternally(const bool is_external);
+	// Distance the target must move (in J-space) before the chain is solved again
+	void SetTargetEpsilon(const double epsilon);
 	void SetLinkAngles(const Eigen::VectorXd& new_angles);
 
 private:
-	// Iterates over each link and recalculates its J-space transform matrices with new angles
+	// Refresh linkData from J_linkAngles, then pass the new rotations to the links
 	void UpdateLinkAngles();
 
 	size_t numLinks;
 	bool renderLinks;
+	bool solvedExternally = false;
 
 	// Empty SceneObject placed at the root of the links, for rotating the leg on the y axis
 	std::shared_ptr<SceneObject> linkRoot;
 	// IKChain has exclusive control over the links attached to it, so make this a vector
 	//   of shared_ptrs instead of weak_ptrs. IKChain manages their lifetime, not the Scene
 	std::vector<std::shared_ptr<Link> > allLinks;
+	// Offset, angle, and cos & sin of the angle of every link, stored contiguously. The
+	//   links are posed from this after each solve
+	ChainLinkData<Eigen::Dynamic> linkData;
 	// Every IKChain must have a target point, but doesn't own/manage it
 	// TODO: figure out how to cast this to a LegTarget
 	std::weak_ptr<SceneObject> target;
 	// Angle of each link in the chain, used to quickly get the chain's current state as
-	//   a starting point for optimization
-	Eigen::MatrixXd J_linkAngles;
+	//   a starting point for optimization. Always double precision, unlike linkData
+	Eigen::VectorXd J_linkAngles;
 	// Location of the end-effector 'r', in the local space of the final link
 	// Note: 2D coordinate, with w = 1.0
 	Eigen::Vector3d J_endEffectorPos;
 
-	// Objects responsible for solving the IK problem
-	OptimizerGDLS optimizerGDLS;
-	OptimizerNM optimizerNM;
-	LinkObjective objectiveFunc;
+	// Object responsible for solving the IK problem, specialized for this chain's size
+	std::unique_ptr<ChainSolver> solver;
 };
 
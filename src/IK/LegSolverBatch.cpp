@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include "LegSolverBatch.h"
+#include "OptimizerAnalytic.h"
+
+LegSolverBatch::LegSolverBatch(const size_t num_chains,
+                               const std::vector<double>& link_offsets,
+                               const Eigen::Vector2d& r, const ChainSolver::Method method) :
+	numChains(num_chains),
+	numLinks(link_offsets.size()),
+	useAnalytic(method == ChainSolver::Method::Auto && link_offsets.size() == 2),
+	linkOffsets(link_offsets),
+	endEffector(r),
+	iterMax(5 * link_offsets.size()) {
+	assert(method == ChainSolver::Method::Auto || method == ChainSolver::Method::Newton);
+	// Copy the objective weights so the batch stays in sync with LinkObjective
+	LinkObjectiveBase default_objective;
+	wTar = default_objective.GetTargetWeight();
+	wReg = default_objective.GetRegularizerWeight();
+	wCon = default_objective.GetConstraintWeight();
+	for (size_t i = 0; i < numLinks; ++i) {
+		restAngles.emplace_back(LinkObjectiveBase::GetRestAngle(i));
+	}
+
+	// Allocate all of the per-chain arrays up front
+	const size_t per_link = numLinks * numChains;
+	angles.assign(per_link, 0.0);
+	targetX.assign(numChains, 0.0);
+	targetY.assign(numChains, 0.0);
+	cachedTargetX.assign(numChains, 0.0);
+	cachedTargetY.assign(numChains, 0.0);
+	hasCache.assign(numChains, 0);
+	fCur.assign(numChains, 0.0);
+	fNew.assign(numChains, 0.0);
+	gCur.assign(per_link, 0.0);
+	gNew.assign(per_link, 0.0);
+	HCur.assign(numLinks * per_link, 0.0);
+	HNew.assign(numLinks * per_link, 0.0);
+	ldlFactor.assign(numLinks * per_link, 0.0);
+	phi.assign(numChains, 0.0);
+	suffixX.assign((numLinks + 1) * numChains, 0.0);
+	suffixY.assign((numLinks + 1) * numChains, 0.0);
+	dpX.assign(numChains, 0.0);
+	dpY.assign(numChains, 0.0);
+	xTrial.assign(per_link, 0.0);
+	dx.assign(per_link, 0.0);
+	lambda.assign(numChains, 0.0);
+	nu.assign(numChains, 0.0);
+	radius.assign(numChains, 0.0);
+	stepLen.assign(numChains, 0.0);
+	stepScale.assign(numChains, 0.0);
+	predicted.assign(numChains, 0.0);
+	active.assign(numChains, 0);
+	hasStep.assign(numChains, 0);
+	accepted.assign(numChains, 0);
+	iterations.assign(numChains, 0);
+}
+
+void LegSolverBatch::Solve() {
+	auto start = std::chrono::steady_clock::now();
+	// Only solve the chains whose targets have moved. The rest keep their previous result
+	for (size_t c = 0; c < numChains; ++c) {
+		const double dx = targetX[c] - cachedTargetX[c];
+		const double dy = targetY[c] - cachedTargetY[c];
+		const bool is_hit = hasCache[c] && (dx * dx + dy * dy) < targetEpsilon * targetEpsilon;
+		active[c] = is_hit ? 0 : 1;
+		if (is_hit) {
+			++numCacheHits;
+		}
+		else {
+			++numCacheMisses;
+			hasCache[c] = 1;
+			cachedTargetX[c] = targetX[c];
+			cachedTargetY[c] = targetY[c];
+		}
+	}
+	if (useAnalytic) {
+		OptimizeAnalytic(angles);
+	}
+	else {
+		OptimizeNM(angles);
+	}
+
+	// Wrap angles to the range [-pi, pi]
+	const double pi = 3.1415926535;
+	for (double& a : angles) {
+		a -= 2.0 * pi * std::floor((a + pi) / (2.0 * pi));
+	}
+	auto end = std::chrono::steady_clock::now();
+	solveTimeUs = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+void LegSolverBatch::GetAngles(const size_t chain_idx, Eigen::VectorXd& out_angles) const {
+	assert(chain_idx < numChains);
+	out_angles.resize(numLinks);
+	for (size_t i = 0; i < numLinks; ++i) {
+		out_angles(i) = angles[Idx(i, chain_idx)];
+	}
+}
+
+ChainSolver::SolveStats LegSolverBatch::GetStats(const size_t chain_idx) const {
+	assert(chain_idx < numChains);
+	ChainSolver::SolveStats stats;
+	stats.iterations = iterations[chain_idx];
+	stats.timeUs = solveTimeUs / numChains;
+	stats.cacheHit = (iterations[chain_idx] == 0);
+	return stats;
+}
+
+void LegSolverBatch::SetTarget(const size_t chain_idx, const Eigen::Vector2d& target) {
+	assert(chain_idx < numChains);
+	targetX[chain_idx] = target.x();
+	targetY[chain_idx] = target.y();
+}
+
+void LegSolverBatch::SetAngles(const size_t chain_idx, const Eigen::VectorXd& new_angles) {
+	assert(chain_idx < numChains && (size_t)new_angles.rows() == numLinks);
+	for (size_t i = 0; i < numLinks; ++i) {
+		angles[Idx(i, chain_idx)] = new_angles(i);
+	}
+	hasCache[chain_idx] = 0;
+}
+
+// PRIVATE FUNCTIONS
+
+void LegSolverBatch::EvalObjective(const std::vector<double>& theta, std::vector<double>& f,
+                                   std::vector<double>* g, std::vector<double>* H) {
+	const size_t C = numChains;
+	/* ----- Forward kinematics (see ChainKinematics) ----- */
+	std::fill(phi.begin(), phi.end(), 0.0);
+	for (size_t i = 0; i < numLinks; ++i) {
+		const double offset = linkOffsets[i];
+		double* sx = &suffixX[i * C];
+		double* sy = &suffixY[i * C];
+		const double* t = &theta[i * C];
+		for (size_t c = 0; c < C; ++c) {
+			sx[c] = offset * cos(phi[c]);
+			sy[c] = offset * sin(phi[c]);
+			phi[c] += t[c];
+		}
+	}
+	{
+		double* sx = &suffixX[numLinks * C];
+		double* sy = &suffixY[numLinks * C];
+		const double rx = endEffector.x();
+		const double ry = endEffector.y();
+		for (size_t c = 0; c < C; ++c) {
+			const double cos_phi = cos(phi[c]);
+			const double sin_phi = sin(phi[c]);
+			sx[c] = cos_phi * rx - sin_phi * ry;
+			sy[c] = sin_phi * rx + cos_phi * ry;
+		}
+	}
+	for (int i = (int)numLinks - 1; i >= 0; --i) {
+		double* sx = &suffixX[i * C];
+		double* sy = &suffixY[i * C];
+		const double* sx_next = &suffixX[(i + 1) * C];
+		const double* sy_next = &suffixY[(i + 1) * C];
+		for (size_t c = 0; c < C; ++c) {
+			sx[c] += sx_next[c];
+			sy[c] += sy_next[c];
+		}
+	}
+
+	/* ----- Objective value ----- */
+	for (size_t c = 0; c < C; ++c) {
+		dpX[c] = suffixX[c] - targetX[c];
+		dpY[c] = suffixY[c] - targetY[c];
+		f[c] = wTar * (dpX[c] * dpX[c] + dpY[c] * dpY[c]);
+	}
+	for (size_t i = 0; i < numLinks; ++i) {
+		const double* t = &theta[i * C];
+		const double rest = restAngles[i];
+		for (size_t c = 0; c < C; ++c) {
+			const double dt = t[c] - rest;
+			f[c] += wReg * t[c] * t[c] + wCon * dt * dt;
+		}
+	}
+	for (size_t c = 0; c < C; ++c) {
+		f[c] /= 3.0;
+	}
+
+	if (g == nullptr) {
+		return;
+	}
+	/* ----- Gradient ----- */
+	// dp/dtheta_j is the (joint j -> end effector) vector rotated by 90 degrees
+	const double scale = 2.0 / 3.0;
+	for (size_t j = 0; j < numLinks; ++j) {
+		const double* sx = &suffixX[(j + 1) * C];
+		const double* sy = &suffixY[(j + 1) * C];
+		const double* t = &theta[j * C];
+		const double rest = restAngles[j];
+		double* gj = &(*g)[j * C];
+		for (size_t c = 0; c < C; ++c) {
+			gj[c] = scale * (wTar * (dpY[c] * sx[c] - dpX[c] * sy[c]) + wReg * t[c] +
+				wCon * (t[c] - rest));
+		}
+	}
+
+	if (H == nullptr) {
+		return;
+	}
+	/* ----- Hessian ----- */
+	// P'_j . P'_k is the dot of the two unrotated suffix vectors, and dp . P"_jk is the
+	//   negated dot of dp with the suffix after the outermost joint
+	for (size_t j = 0; j < numLinks; ++j) {
+		const double* sxj = &suffixX[(j + 1) * C];
+		const double* syj = &suffixY[(j + 1) * C];
+		for (size_t k = j; k < numLinks; ++k) {
+			const double* sxk = &suffixX[(k + 1) * C];
+			const double* syk = &suffixY[(k + 1) * C];
+			const double reg = (j == k) ? wReg + wCon : 0.0;
+			double* hjk = &(*H)[(j * numLinks + k) * C];
+			double* hkj = &(*H)[(k * numLinks + j) * C];
+			for (size_t c = 0; c < C; ++c) {
+				const double pp = sxj[c] * sxk[c] + syj[c] * syk[c];
+				const double dp_p2 = dpX[c] * sxk[c] + dpY[c] * syk[c];
+				hjk[c] = scale * (wTar * (pp - dp_p2) + reg);
+				hkj[c] = hjk[c];
+			}
+		}
+	}
+}
+
+void LegSolverBatch::OptimizeAnalytic(std::vector<double>& x) {
+	assert(numLinks == 2);
+	const Eigen::Vector2d rest(restAngles[0], restAngles[1]);
+	for (size_t c = 0; c < numChains; ++c) {
+		iterations[c] = active[c] ? 1 : 0;
+		if (!active[c]) {
+			continue;
+		}
+		// Move the target into the space of the root joint (the first offset is never rotated)
+		const Eigen::Vector2d target(targetX[c] - linkOffsets[0], targetY[c]);
+		const Eigen::Vector2d result = OptimizerAnalytic::SolveAngles(linkOffsets[1],
+			endEffector, target, rest);
+		x[Idx(0, c)] = result(0);
+		x[Idx(1, c)] = result(1);
+	}
+}
+
+void LegSolverBatch::OptimizeNM(std::vector<double>& x) {
+	// Note: only chains that are marked active when this is called are optimized
+	std::fill(iterations.begin(), iterations.end(), 0);
+	if (std::none_of(active.begin(), active.end(), [](char a) { return a != 0; })) {
+		return;
+	}
+	const size_t C = numChains;
+	const size_t n = numLinks;
+
+	// Evaluate f, g, and H for every chain at the starting point
+	EvalObjective(x, fCur, &gCur, &HCur);
+	for (size_t c = 0; c < C; ++c) {
+		double max_diag = 1.0;
+		for (size_t i = 0; i < n; ++i) {
+			max_diag = std::max(max_diag, std::abs(HCur[(i * n + i) * C + c]));
+		}
+		lambda[c] = dampingInit * max_diag;
+		nu[c] = 2.0;
+		radius[c] = trustRadiusInit;
+	}
+
+	for (size_t iter = 1; iter <= iterMax; ++iter) {
+		if (std::none_of(active.begin(), active.end(), [](char a) { return a != 0; })) {
+			break;
+		}
+		for (size_t c = 0; c < C; ++c) {
+			hasStep[c] = active[c];
+			if (active[c]) {
+				iterations[c] = iter;
+			}
+		}
+
+		/* ----- Factor H + lambda * I = L * D * L^T for every chain ----- */
+		// Same test as OptimizerNM: if any pivot isn't positive, the damped Hessian isn't
+		//   positive definite, so that chain raises its damping and retries next iteration.
+		//   The factorization has no pivoting, so every chain runs the same operations
+		for (size_t j = 0; j < n; ++j) {
+			double* d_j = &ldlFactor[(j * n + j) * C];
+			const double* h_jj = &HCur[(j * n + j) * C];
+			for (size_t c = 0; c < C; ++c) {
+				d_j[c] = h_jj[c] + lambda[c];
+			}
+			for (size_t k = 0; k < j; ++k) {
+				const double* l_jk = &ldlFactor[(j * n + k) * C];
+				const double* d_k = &ldlFactor[(k * n + k) * C];
+				for (size_t c = 0; c < C; ++c) {
+					d_j[c] -= l_jk[c] * l_jk[c] * d_k[c];
+				}
+			}
+			for (size_t c = 0; c < C; ++c) {
+				hasStep[c] = (hasStep[c] && d_j[c] > 0.0) ? 1 : 0;
+				// Keep the failed chains finite, since they still go through every loop
+				d_j[c] = (d_j[c] > 0.0) ? d_j[c] : 1.0;
+			}
+			for (size_t i = j + 1; i < n; ++i) {
+				double* l_ij = &ldlFactor[(i * n + j) * C];
+				const double* h_ij = &HCur[(i * n + j) * C];
+				for (size_t c = 0; c < C; ++c) {
+					l_ij[c] = h_ij[c];
+				}
+				for (size_t k = 0; k < j; ++k) {
+					const double* l_ik = &ldlFactor[(i * n + k) * C];
+					const double* l_jk = &ldlFactor[(j * n + k) * C];
+					const double* d_k = &ldlFactor[(k * n + k) * C];
+					for (size_t c = 0; c < C; ++c) {
+						l_ij[c] -= l_ik[c] * l_jk[c] * d_k[c];
+					}
+				}
+				for (size_t c = 0; c < C; ++c) {
+					l_ij[c] /= d_j[c];
+				}
+			}
+		}
+
+		/* ----- Solve for the step dx = -(H + lambda * I)^-1 * g ----- */
+		// Forward substitution (L * y = -g), then the diagonal, then back substitution
+		for (size_t i = 0; i < n; ++i) {
+			double* dx_i = &dx[i * C];
+			const double* g_i = &gCur[i * C];
+			for (size_t c = 0; c < C; ++c) {
+				dx_i[c] = -g_i[c];
+			}
+			for (size_t k = 0; k < i; ++k) {
+				const double* l_ik = &ldlFactor[(i * n + k) * C];
+				const double* dx_k = &dx[k * C];
+				for (size_t c = 0; c < C; ++c) {
+					dx_i[c] -= l_ik[c] * dx_k[c];
+				}
+			}
+		}
+		for (size_t i = 0; i < n; ++i) {
+			double* dx_i = &dx[i * C];
+			const double* d_i = &ldlFactor[(i * n + i) * C];
+			for (size_t c = 0; c < C; ++c) {
+				dx_i[c] /= d_i[c];
+			}
+		}
+		for (int i = (int)n - 1; i >= 0; --i) {
+			double* dx_i = &dx[i * C];
+			for (size_t k = i + 1; k < n; ++k) {
+				const double* l_ki = &ldlFactor[(k * n + i) * C];
+				const double* dx_k = &dx[k * C];
+				for (size_t c = 0; c < C; ++c) {
+					dx_i[c] -= l_ki[c] * dx_k[c];
+				}
+			}
+		}
+
+		/* ----- Clamp each step to its trust region and predict the reduction ----- */
+		std::fill(stepLen.begin(), stepLen.end(), 0.0);
+		for (size_t i = 0; i < n; ++i) {
+			const double* dx_i = &dx[i * C];
+			for (size_t c = 0; c < C; ++c) {
+				stepLen[c] += dx_i[c] * dx_i[c];
+			}
+		}
+		for (size_t c = 0; c < C; ++c) {
+			stepLen[c] = std::sqrt(stepLen[c]);
+			// Chains without a step get a zero step, so their trial point is unchanged
+			stepScale[c] = !hasStep[c] ? 0.0 :
+				(stepLen[c] > radius[c]) ? radius[c] / stepLen[c] : 1.0;
+			stepLen[c] = std::min(stepLen[c], radius[c]);
+		}
+		// Undo the damping to get the model's predicted reduction: -(g.dx + 0.5 * dx.H.dx)
+		std::fill(predicted.begin(), predicted.end(), 0.0);
+		for (size_t i = 0; i < n; ++i) {
+			double* dx_i = &dx[i * C];
+			const double* g_i = &gCur[i * C];
+			const double* x_i = &x[i * C];
+			double* x_trial_i = &xTrial[i * C];
+			for (size_t c = 0; c < C; ++c) {
+				dx_i[c] *= stepScale[c];
+				predicted[c] -= g_i[c] * dx_i[c];
+				x_trial_i[c] = x_i[c] + dx_i[c];
+			}
+		}
+		for (size_t i = 0; i < n; ++i) {
+			const double* dx_i = &dx[i * C];
+			for (size_t k = 0; k < n; ++k) {
+				const double* h_ik = &HCur[(i * n + k) * C];
+				const double* dx_k = &dx[k * C];
+				for (size_t c = 0; c < C; ++c) {
+					predicted[c] -= 0.5 * dx_i[c] * h_ik[c] * dx_k[c];
+				}
+			}
+		}
+
+		// Test every step at once. g and H are evaluated at the trial point as well, so an
+		//   accepted step doesn't need to evaluate the chain again
+		EvalObjective(xTrial, fNew, &gNew, &HNew);
+		for (size_t c = 0; c < C; ++c) {
+			accepted[c] = 0;
+			if (!active[c]) {
+				continue;
+			}
+			if (!hasStep[c]) {
+				lambda[c] *= nu[c];
+				nu[c] *= 2.0;
+				continue;
+			}
+			const double rho = (predicted[c] > 0.0) ? (fCur[c] - fNew[c]) / predicted[c] : -1.0;
+			if (rho > 0.0) {
+				accepted[c] = 1;
+				const double scale = 2.0 * rho - 1.0;
+				lambda[c] *= std::max(1.0 / 3.0, 1.0 - scale * scale * scale);
+				nu[c] = 2.0;
+				if (rho > 0.75) {
+					radius[c] = std::max(radius[c], 2.0 * stepLen[c]);
+				}
+				else if (rho < 0.25) {
+					radius[c] *= 0.5;
+				}
+				if (stepLen[c] < tol) {
+					active[c] = 0;
+				}
+			}
+			else {
+				lambda[c] *= nu[c];
+				nu[c] *= 2.0;
+				radius[c] = 0.5 * stepLen[c];
+				if (radius[c] < tol) {
+					active[c] = 0;
+				}
+			}
+		}
+
+		/* ----- Move the chains that accepted their step ----- */
+		for (size_t c = 0; c < C; ++c) {
+			fCur[c] = accepted[c] ? fNew[c] : fCur[c];
+		}
+		for (size_t i = 0; i < n; ++i) {
+			double* x_i = &x[i * C];
+			double* g_i = &gCur[i * C];
+			const double* x_trial_i = &xTrial[i * C];
+			const double* g_new_i = &gNew[i * C];
+			for (size_t c = 0; c < C; ++c) {
+				x_i[c] = accepted[c] ? x_trial_i[c] : x_i[c];
+				g_i[c] = accepted[c] ? g_new_i[c] : g_i[c];
+			}
+		}
+		for (size_t i = 0; i < n * n; ++i) {
+			double* h_i = &HCur[i * C];
+			const double* h_new_i = &HNew[i * C];
+			for (size_t c = 0; c < C; ++c) {
+				h_i[c] = accepted[c] ? h_new_i[c] : h_i[c];
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "ChainSolver.h"
+#include "LinkObjective.h"
+
+///
+/// Solves the IK problems for a group of identical chains (i.e. all legs on a spider)
+/// in lockstep. Runs the same damped newton's method as ChainSolver, but every per-chain
+/// quantity is stored as a structure-of-arrays indexed by [link][chain], so the inner
+/// loops run across chains and can be vectorized by the compiler. This includes the small
+/// LDL^T solve for each newton step. Like ChainSolver, the Auto method solves 2-link chains
+/// analytically instead, and Newton always iterates.
+///
+/// Usage: set each chain's target (and optionally its starting angles), call Solve(),
+/// then read the angles back out. Angles are kept between solves, so each solve starts
+/// from the previous result. Chains whose target moved less than the target epsilon
+/// since their last solve are skipped entirely.
+///
+class LegSolverBatch {
+public:
+	// 'method' must be Auto or Newton, the only methods that can be batched
+	LegSolverBatch(const size_t num_chains, const std::vector<double>& link_offsets,
+	               const Eigen::Vector2d& r,
+	               const ChainSolver::Method method = ChainSolver::Method::Auto);
+	~LegSolverBatch() = default;
+
+	// Solve every chain whose target has moved
+	void Solve();
+
+	/* ----- Getters ----- */
+	size_t GetNumChains() const { return numChains; }
+	size_t GetNumLinks() const { return numLinks; }
+	void GetAngles(const size_t chain_idx, Eigen::VectorXd& out_angles) const;
+	// Profiling info for the chain from the most recent Solve. Since every chain is
+	//   solved together, the time is the whole batch's time split evenly between chains
+	ChainSolver::SolveStats GetStats(const size_t chain_idx) const;
+	// Number of chain solves that were skipped/run since the batch was created
+	size_t GetNumCacheHits() const { return numCacheHits; }
+	size_t GetNumCacheMisses() const { return numCacheMisses; }
+
+	/* ----- Setters ----- */
+	void SetTarget(const size_t chain_idx, const Eigen::Vector2d& target);
+	// Note: clears the chain's cached result, so it's always solved on the next Solve
+	void SetAngles(const size_t chain_idx, const Eigen::VectorXd& new_angles);
+	// Distance a chain's target must move (in J-space) before it is solved again
+	void SetTargetEpsilon(const double epsilon) { targetEpsilon = epsilon; }
+
+private:
+	// Evaluate the objective for every chain at angles theta (SoA layout). Same objective
+	//   as LinkObjective::evalObjective. g and H are optional, and H requires g
+	void EvalObjective(const std::vector<double>& theta, std::vector<double>& f,
+	                   std::vector<double>* g = nullptr, std::vector<double>* H = nullptr);
+	// Lockstep version of OptimizerNM, operating on 'x' in place
+	void OptimizeNM(std::vector<double>& x);
+	// Solve each active 2-link chain with OptimizerAnalytic, operating on 'x' in place
+	void OptimizeAnalytic(std::vector<double>& x);
+	// Index into an SoA array with one entry per link per chain
+	inline size_t Idx(const size_t link_idx, const size_t chain_idx) const {
+		return link_idx * numChains + chain_idx;
+	}
+
+	const size_t numChains;
+	const size_t numLinks;
+	// Solve 2-link chains with OptimizerAnalytic instead of newton's method?
+	const bool useAnalytic;
+	// Chain geometry, shared by every chain in the batch
+	std::vector<double> linkOffsets;
+	Eigen::Vector2d endEffector;
+	// Objective weights, copied from a default LinkObjective so the batch solves the
+	//   same problem as the per-chain path
+	double wTar;
+	double wReg;
+	double wCon;
+	std::vector<double> restAngles;
+	// Optimizer settings, matching the defaults in OptimizerNM
+	double tol = 1e-3;
+	double dampingInit = 1e-3;
+	double trustRadiusInit = 0.5;
+	size_t iterMax;
+
+	/* ----- Per-chain state (SoA) ----- */
+	// Current angle of each link, [link][chain]
+	std::vector<double> angles;
+	// Local-space target of each chain, [chain]
+	std::vector<double> targetX;
+	std::vector<double> targetY;
+
+	/* ----- Result cache ----- */
+	double targetEpsilon = 0.0;
+	// Target from each chain's most recent solve [chain], and whether it's valid
+	std::vector<double> cachedTargetX;
+	std::vector<double> cachedTargetY;
+	std::vector<char> hasCache;
+	size_t numCacheHits = 0;
+	size_t numCacheMisses = 0;
+
+	/* ----- Scratch buffers, kept between solves to avoid reallocation ----- */
+	// Results of EvalObjective: f [chain], g [link][chain], H [row][col][chain]. 'Cur' is
+	//   at the current angles, and 'New' is at the trial angles
+	std::vector<double> fCur;
+	std::vector<double> fNew;
+	std::vector<double> gCur;
+	std::vector<double> gNew;
+	std::vector<double> HCur;
+	std::vector<double> HNew;
+	// LDL^T factorization of each chain's damped Hessian [row][col][chain], with L below
+	//   the diagonal and D on it
+	std::vector<double> ldlFactor;
+	// Total angle of the chain up to the current link [chain]
+	std::vector<double> phi;
+	// Suffix sums of the chain segments, [link + 1][chain]. Same layout as ChainKinematics
+	std::vector<double> suffixX;
+	std::vector<double> suffixY;
+	// Vector from the target to the end effector [chain]
+	std::vector<double> dpX;
+	std::vector<double> dpY;
+	// Optimizer state. lambda, nu and radius have the same meaning as in OptimizerNM
+	std::vector<double> xTrial;
+	// Newton step [link][chain], and the factor that clamps it to the trust region [chain]
+	std::vector<double> dx;
+	std::vector<double> stepScale;
+	std::vector<double> lambda;
+	std::vector<double> nu;
+	std::vector<double> radius;
+	std::vector<double> stepLen;
+	std::vector<double> predicted;
+	// Flags for which chains are still iterating, which chains found a valid step this
+	//   iteration, and which chains took their step. Stored as chars, since vector<bool>
+	//   is bit-packed and can't be vectorized
+	std::vector<char> active;
+	std::vector<char> hasStep;
+	std::vector<char> accepted;
+	// Profiling info from the most recent solve
+	std::vector<int> iterations;
+	double solveTimeUs = 0.0;
+};
@@ -17,11 +17,13 @@ LegTarget::LegTarget(std::weak_ptr<GameEngine> engine, const std::string& name,
 {}
 
 void LegTarget::BeginPlay() {
-	// Initialize the modelMtx with the full set of parent transforms, without
-	//   interpolation
+	// Take over the model matrix, initializing it with the full set of parent transforms,
+	//   without interpolation
+	glm::mat4 world_mtx = GetRelativeTransform().GetMatrix();
 	if (!parent.expired()) {
-		modelMtx = parent.lock()->GetWorldTransformMtx() * rootTransform.GetMatrix();
+		world_mtx = parent.lock()->GetWorldTransformMtx() * world_mtx;
 	}
+	SetWorldTransformMtx(world_mtx);
 	// (optionally) Create the visualizer mesh
 	if (visualizeMesh) {
 		vizMesh = std::make_shared<ModelObject>(engineRef, objectName + "_vizmesh");
@@ -43,9 +45,9 @@ void LegTarget::PhysicsUpdate(const float delta_time) {
 	// Even if I need to move, never start moving on the next physics tick after
 	//   a successful move (give neighbors a chance to start moving instead)
 	if (!justFinishedMoving) {
-		if (physicsDirty && !are_neighbors_moving) {
+		if (IsPhysicsDirty() && !are_neighbors_moving) {
 			// Find the world-space transform of the goal point
-			glm::mat4 goalMtx = rootTransform.GetMatrix();
+			glm::mat4 goalMtx = GetRelativeTransform().GetMatrix();
 			if (!parent.expired()) {
 				goalMtx = parent.lock()->GetWorldTransformMtx() * goalMtx;
 			}
@@ -64,11 +66,12 @@ void LegTarget::PhysicsUpdate(const float delta_time) {
 
 			// Always update rotation & scale in the model matrix, no matter what the
 			//   location is. But leave translation (col 3) up to the interpolation code
-			modelMtx[0] = goalMtx[0];
-			modelMtx[1] = goalMtx[1];
-			modelMtx[2] = goalMtx[2];
+			glm::mat4 world_mtx = GetWorldTransformMtx();
+			world_mtx[0] = goalMtx[0];
+			world_mtx[1] = goalMtx[1];
+			world_mtx[2] = goalMtx[2];
 			// Mark physics clean, but it might be re-marked later if interpolation is needed
-			physicsDirty = false;
+			ClearPhysicsDirty();
 
 			// If this leg is already moving, continue lerping between the prevLoc
 			//   and goalLoc
@@ -82,9 +85,9 @@ void LegTarget::PhysicsUpdate(const float delta_time) {
 					// Offset the interp location by a vertical curve (for leg-lifting effect)
 					// TODO: offset this in the spidercharacter's up vector, not y
 					interpLoc.y += sin(alpha * PI) * legLiftHeight;
-					modelMtx[3] = interpLoc;
+					world_mtx[3] = interpLoc;
 					lerpTimer += delta_time;
-					// Each update, re-mark physics dirty to propagate changes to children
+					// Each update, re-mark physics dirty so the lerp continues next tick
 					MarkPhysicsDirty();
 				}
 				else {
@@ -94,32 +97,22 @@ void LegTarget::PhysicsUpdate(const float delta_time) {
 			}
 			else {
 				// Leg is not moving, so check whether it should start
-				float distance = glm::length(goalLoc - modelMtx[3]);
+				float distance = glm::length(goalLoc - world_mtx[3]);
 				if (distance > threshold) {
 					// Start moving
 					isLegMoving = true;
 					lerpTimer = 0.0f;
 					// Save the location when the threshold was reached
-					prevLoc = modelMtx[3];
+					prevLoc = world_mtx[3];
 				}
 			}
+			SetWorldTransformMtx(world_mtx);
 		}
 	}
 	else {
 		// After waiting an extra PhysicsUpdate, allow this LegTarget to start moving again
 		justFinishedMoving = false;
 	}
-
-	// Propagate physics to children
-	for (auto& child : childObjects) {
-		if (!child.expired()) {
-			child.lock()->PhysicsUpdate(delta_time);
-		}
-		else {
-			std::cerr << "ERROR: Attempted to update physics on an invalid ";
-			std::cerr << "child object!" << std::endl;
-		}
-	}
 }
 
 void LegTarget::Render(const std::shared_ptr<ShaderProgram> shader) const {
@@ -12,7 +12,8 @@ class ModelObject;
 
 ///
 /// Empty SceneObject that lazily updates its model matrix location to match its
-/// relative transform. Rotation & scale changes are immediately updated, but location
+/// relative transform. Its model matrix is set directly in the TransformSystem, rather
+/// than being derived from its parent. Rotation & scale changes are immediately updated, but location
 /// changes are only applied to the model matrix if they fall outside a certain radius
 /// from the relative transform's world position
 ///
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -24,9 +26,6 @@ void Link::BeginPlay() {
 }
 
 void Link::PhysicsUpdate(const float delta_time) {
-	// Note: the J matrices are NOT updated during physicsupdate. They are the 2D J-space
-	// transforms of the link, not the modelMatrix that will actually be used in rendering
-	
 	SceneObject::PhysicsUpdate(delta_time);
 }
 
@@ -35,28 +34,13 @@ void Link::Render(const std::shared_ptr<ShaderProgram> shader) const {
 	linkMesh->Render(shader);
 }
 
-void Link::SetLinkAngle(double a) {	
-	// Apply new angle to this link's local transform
-	// TODO: check if a rotation along z is correct
-	rootTransform.rot = Transform::EulerToQuat(glm::vec3(0.0, 0.0, a));
+void Link::SetLinkRotation(const float cos_angle, const float sin_angle) {
+	// Rotation about z by angle a is the quaternion (cos(a/2), 0, 0, sin(a/2)). Use the
+	//   half-angle identities, which hold for the wrapped range [-pi, pi]
+	const float cos_half = sqrt(std::max(0.0f, 0.5f * (1.0f + cos_angle)));
+	const float sin_half = std::copysign(sqrt(std::max(0.0f, 0.5f * (1.0f - cos_angle))),
+	                                     sin_angle);
+	// Note: quat constructor is (w, x, y, z)
+	GetMutableRelativeTransform().rot = glm::quat(cos_half, 0.0f, 0.0f, sin_half);
 	MarkPhysicsDirty();
-
-	// Recalculate the J matrices for this link
-	double cosT = cos(a);
-	double sinT = sin(a);
-	J <<
-		cosT, -1.0 * sinT, rootTransform.loc.x,
-		sinT, cosT, rootTransform.loc.y,
-		0, 0, 1;
-	// Note: translation coords are 0 for J' and J", because
-	//   R matrix has homogeneous coord of 0 (which nullifies
-	//   the translation matrix)
-	JPrime <<
-		-1.0 * sinT, -1.0 * cosT, 0,
-		cosT, -1.0 * sinT, 0,
-		0, 0, 0;
-	J2Prime <<
-		-1.0 * cosT, sinT, 0,
-		-1.0 * sinT, -1.0 * cosT, 0,
-		0, 0, 0;
 }
@@ -2,8 +2,6 @@
 
 #include <memory>
 
-#include <eigen-3.4.0/Eigen/Dense>
-
 #include "../Rendering/SceneObject.h"
 class ModelObject;
 
@@ -15,8 +13,6 @@ class ModelObject;
 /// 
 class Link : public SceneObject {
 public:
-	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-	
 	Link(std::weak_ptr<GameEngine> engine, const std::string& name, const float length);
 	~Link() = default;
 
@@ -25,26 +21,14 @@ public:
 	virtual void PhysicsUpdate(const float delta_time);
 	virtual void Render(const std::shared_ptr<ShaderProgram> shader) const;
 
-	// Getters for the transformation matrix & its derivatives
-	const Eigen::Matrix3d& GetJ() const { return J; }
-	const Eigen::Matrix3d& GetJPrime() const { return JPrime; }
-	const Eigen::Matrix3d& GetJ2Prime() const { return J2Prime; }
-
-	// Set the angle (in radians) for this link
-	void SetLinkAngle(double a);
+	// Set this link's rotation about its z axis, from the cos & sin of its angle. The
+	//   owning IKChain already has those on hand, so no trig functions are needed here
+	void SetLinkRotation(const float cos_angle, const float sin_angle);
 	
 private:
 	std::shared_ptr<ModelObject> linkMesh;
 
 	// Length of this link (distance to the next link's root along the x axis)
 	const float linkLength = 1.0f;
-
-	// Store the joint transformation matrices for this link in LOCAL space,
-	//   which are equal to TR(theta), TR'(theta), and TR"(theta).
-	//  (Note: Scale transforms don't apply to links for this reason)
-	// TODO: check that ^
-	Eigen::Matrix3d J;
-	Eigen::Matrix3d JPrime;
-	Eigen::Matrix3d J2Prime;
 };
 
@@ -3,107 +3,107 @@
 #include <cassert>
 
 #include "LinkObjective.h"
-#include "IKChain.h"
 
-LinkObjective::LinkObjective() :
+double LinkObjectiveBase::GetRestAngle(const size_t link_idx) {
+	// Array of ideal resting angles for each leg
+	constexpr double pi = 3.14159;
+	// in degrees: 45, -105. Every link after these rests straight (0)
+	constexpr double rest_angles[2] = { pi / 4.0, (-7.0 * pi) / 12.0 };
+	return (link_idx < 2) ? rest_angles[link_idx] : 0.0;
+}
+
+LinkObjectiveBase::LinkObjectiveBase() :
 	wTar(1e3),
 	wReg(1e1),
 	wCon(1e2),
 	pTarget(0.0, 0.0) {}
 
-double LinkObjective::evalObjective(const Eigen::VectorXd& theta,
-                                    Eigen::VectorXd* g,
-                                    Eigen::MatrixXd* H) const {
-	assert(chain);
-	// Update the chain with the new angles
-	chain->SetLinkAngles(theta);
-	const size_t num_links = chain->GetNumLinks();
-	const Eigen::Vector3d r = chain->GetEndEffectorPos();
-	// Use a temporary var to accumulate the transformation matrices of each link
-	Eigen::Vector3d pTemp = r;
+template <int N>
+double LinkObjective<N>::evalObjective(const Vector& theta, Vector* g, Hessian* H) const {
+	assert(kinematics.GetNumLinks() > 0);
+	const size_t num_links = kinematics.GetNumLinks();
 
-	// Find the position vector (location of end effector in world space)
-	for (int link_idx = num_links - 1; link_idx >= 0; --link_idx) {
-		pTemp = chain->GetJMatrix(link_idx, 0) * pTemp;
-	}
-	Eigen::Vector2d p = pTemp.head<2>();
+	// Find the position vector (location of end effector in world space). This also
+	//   leaves the suffix sums of the chain segments in the link data, which give the
+	//   position's derivatives w.r.t. theta if they're needed for g and/or H
+	Eigen::Vector2d p = kinematics.Evaluate(theta);
 
 	Eigen::Vector2d dp = p - pTarget;
 
-	// Assuming the starting angles of all links are 0
-	Eigen::VectorXd dTheta = theta;
-	
-	// Calculate objective value. Note: .value() is required to convert a 1x1 matrix to a double
-	double target_factor = wTar * dp.transpose() * dp;
-	double reg_factor = (wReg * dTheta.transpose() * dTheta).value();
-	double constraint_factor = wCon * CalcConstraintFactor(dTheta);
+	// Calculate objective value. Note: assuming the starting angles of all links are 0,
+	//   so the regularizer just uses theta
+	double target_factor = wTar * dp.squaredNorm();
+	double reg_factor = wReg * theta.squaredNorm();
+	double constraint_factor = wCon * CalcConstraintFactor(theta);
 	double f = (target_factor + constraint_factor + reg_factor) / 3.0;
 
-	// If g and/or H are provided, calculate the derivatives of the position vector w.r.t each theta, then
-	// set the gradient vector and Hessian matrix
+	// If g and/or H are provided, use the derivatives of the position vector w.r.t each
+	//   theta to set the gradient vector and Hessian matrix. These are the exact derivatives
+	//   of f (including the 1/3 scaling and the constraint term), so that optimizers can
+	//   compare the reduction they predict with the actual change in f. Both are read
+	//   straight from the suffix sums (see ChainKinematics), so no derivative matrices are
+	//   built. Suffix sum j + 1 is the vector from joint j to the end effector
 	if (g != nullptr) {
-		Eigen::MatrixXd PPrime(2, num_links);
-		// Find the derivative of the P vector w.r.t theta
-		for (size_t p_idx = 0; p_idx < num_links; ++p_idx) {
-			pTemp = r;
-			for (int link_idx = num_links - 1; link_idx >= 0; --link_idx) {
-				// If the current link matches the p vector that is being set, get J' instead of J
-				size_t derivative = (size_t)(link_idx == p_idx);
-				const auto& J = chain->GetJMatrix(link_idx, derivative);
-				pTemp = chain->GetJMatrix(link_idx, derivative) * pTemp;
-			}
-			// Set the block of values at position 0, pidx and size 2, 1 to the p vector
-			PPrime.block(0, p_idx, 2, 1) << pTemp.head<2>();
-		}
-
-		// Find the gradient, which requires the dot product of dp with each p vector in PPrime
-		Eigen::VectorXd dpDotPPrime(num_links);
-		for (size_t p_idx = 0; p_idx < num_links; ++p_idx) {
-			dpDotPPrime(p_idx) = (dp.transpose() * PPrime.block(0, p_idx, 2, 1)).value();
+		typedef typename Kinematics::LinkData LinkData;
+		const LinkData& link_data = kinematics.GetLinkData();
+		const IKScalar* suffix_x = link_data.GetField(LinkData::SUFFIX_X) + 1;
+		const IKScalar* suffix_y = link_data.GetField(LinkData::SUFFIX_Y) + 1;
+		const double scale = 2.0 / 3.0;
+		// Find the gradient. dp/dtheta_i is suffix i rotated by 90 degrees, dotted with dp
+		g->resize(num_links);
+		for (size_t i = 0; i < num_links; ++i) {
+			const double dp_dot_p1 = dp.y() * suffix_x[i] - dp.x() * suffix_y[i];
+			(*g)(i) = scale * (wTar * dp_dot_p1 + wReg * theta(i) +
+				wCon * (theta(i) - GetRestAngle(i)));
 		}
-		*g = wTar * dpDotPPrime + wReg * dTheta;
 
 		// The hessian can only be provided if g is also provided
 		if (H != nullptr) {
-			// Find the 2nd derivative of the position vector w.r.t theta
-			Eigen::MatrixXd P2Prime(2 * num_links, num_links);
+			// Find the Hessian. The two rotated suffixes dot to the same value as the
+			//   unrotated ones, and d2p is the negated suffix after the outermost joint.
+			//   H is symmetric, so only the upper triangle is computed
+			H->resize(num_links, num_links);
 			for (size_t row = 0; row < num_links; ++row) {
-				for (size_t col = 0; col < num_links; ++col) {
-					pTemp = r;
-					for (int link_idx = num_links - 1; link_idx >= 0; --link_idx) {
-						size_t derivative = (size_t)(link_idx == row) + (size_t)(link_idx == col);
-						pTemp = chain->GetJMatrix(link_idx, derivative) * pTemp;
-					}
-					P2Prime.block(2 * row, col, 2, 1) << pTemp.head<2>();
+				for (size_t col = row; col < num_links; ++col) {
+					const double p1_dot_p1 = (double)suffix_x[row] * suffix_x[col] +
+						(double)suffix_y[row] * suffix_y[col];
+					const double dp_dot_p2 = -1.0 * (dp.x() * suffix_x[col] +
+						dp.y() * suffix_y[col]);
+					(*H)(row, col) = scale * (wTar * (p1_dot_p1 + dp_dot_p2) +
+						((row == col) ? wReg + wCon : 0.0));
+					(*H)(col, row) = (*H)(row, col);
 				}
 			}
-
-			// Find the Hessian, which requires the dot of dp with each p vector in P2Prime
-			Eigen::MatrixXd dpDotP2Prime(num_links, num_links);
-			for (size_t row = 0; row < num_links; ++row) {
-				for (size_t col = 0; col < num_links; ++col) {
-					dpDotP2Prime(row, col) = (dp.transpose() * P2Prime.block(2 * row, col, 2, 1)).value();
-				}
-			}
-			*H = wTar * (PPrime.transpose() * PPrime + dpDotP2Prime) + wReg * Eigen::MatrixXd::Identity(num_links, num_links);
 		}
 	}
 
 	return f;
 }
 
-double LinkObjective::CalcConstraintFactor(const Eigen::VectorXd& theta) const {
+template <int N>
+void LinkObjective<N>::SetChainGeometry(const std::vector<double>& link_offsets,
+                                        const Eigen::Vector2d& r) {
+	kinematics.SetLinkOffsets(link_offsets);
+	kinematics.SetEndEffector(r);
+}
+
+template <int N>
+double LinkObjective<N>::CalcConstraintFactor(const Vector& theta) const {
 	
 	double sum = 0.0;
-	// Array of ideal resting angles for each leg
-	constexpr double pi = 3.14159;
-	// in degrees: 45, -105, 0, ...
-	double rest_angles[8] = { pi / 4.0, (-7.0 * pi) / 12.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-	assert(theta.size() < 8);
 	// Take the squared sum of the difference between each angle and its goal
-	for (size_t i = 0; i < theta.size(); ++i) {
-		double dt = theta(i) - rest_angles[i];
+	for (size_t i = 0; i < (size_t)theta.size(); ++i) {
+		double dt = theta(i) - GetRestAngle(i);
 		sum += dt * dt;
 	}
 	return sum;
 }
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class LinkObjective<2>;
+template class LinkObjective<3>;
+template class LinkObjective<4>;
+template class LinkObjective<5>;
+template class LinkObjective<6>;
+template class LinkObjective<7>;
+template class LinkObjective<Eigen::Dynamic>;
@@ -1,29 +1,35 @@
 #pragma once
 
-#include <memory>
+#include <vector>
 
 #include <eigen-3.4.0/Eigen/Dense>
 
-#include "Link.h"
+#include "ChainKinematics.h"
 
-class IKChain;
-
-class LinkObjective {
+///
+/// Settings shared by every LinkObjective, regardless of chain size: the term weights,
+/// the resting angles, and the current target. Also used directly by solvers that
+/// evaluate the same objective in their own layout (i.e. LegSolverBatch).
+///
+class LinkObjectiveBase {
 public:
-	LinkObjective();
-	~LinkObjective() = default;
-	// Return the objective function f, with optional args for gradient and Hessian
-	double evalObjective(const Eigen::VectorXd& theta, Eigen::VectorXd* g = nullptr, Eigen::MatrixXd* H = nullptr) const;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	// Ideal resting angle of each link, used by the constraint term. Defined for any
+	//   link index
+	static double GetRestAngle(const size_t link_idx);
+
+	LinkObjectiveBase();
+	~LinkObjectiveBase() = default;
 
-	void SetChainRef(std::shared_ptr<IKChain> _chain) { chain = _chain; }
 	void SetTarget(const Eigen::Vector2d& p) { pTarget = p; }
 
-private:
-	// Custom constraint function. 0 if constraints are satisfied, 1 if they are not
-	double CalcConstraintFactor(const Eigen::VectorXd& theta) const;
+	/* ----- Getters ----- */
+	const Eigen::Vector2d& GetTarget() const { return pTarget; }
+	double GetTargetWeight() const { return wTar; }
+	double GetRegularizerWeight() const { return wReg; }
+	double GetConstraintWeight() const { return wCon; }
 
-	// Keep a reference to the chain that this objective function is evaluating
-	std::shared_ptr<IKChain> chain;
+protected:
 	// The most recent target position to compare the chain with
 	Eigen::Vector2d pTarget;
 	// Target weight - prioritizes getting to the target location
@@ -34,3 +40,35 @@ private:
 	double wCon;
 };
 
+///
+/// Objective function for a chain with N links (or Eigen::Dynamic for any number).
+/// With a fixed N, the gradient, Hessian and all of the intermediate values are
+/// fixed-size, so evaluating the objective never allocates.
+///
+template <int N>
+class LinkObjective : public LinkObjectiveBase {
+public:
+	typedef ChainKinematics<N> Kinematics;
+	typedef typename Kinematics::Vector Vector;
+	typedef Eigen::Matrix<double, N, N> Hessian;
+
+	LinkObjective() = default;
+	~LinkObjective() = default;
+	// Return the objective function f, with optional args for gradient and Hessian
+	double evalObjective(const Vector& theta, Vector* g = nullptr, Hessian* H = nullptr) const;
+
+	// Copy the chain's link offsets & end effector, so that the objective can be evaluated
+	//   without modifying the chain itself
+	void SetChainGeometry(const std::vector<double>& link_offsets, const Eigen::Vector2d& r);
+
+	/* ----- Getters ----- */
+	const Kinematics& GetKinematics() const { return kinematics; }
+
+private:
+	// Custom constraint function. 0 if constraints are satisfied, 1 if they are not
+	double CalcConstraintFactor(const Vector& theta) const;
+
+	// Forward kinematics for the chain that this objective function is evaluating. Its
+	//   link data also holds the suffix sums that g and H are built from
+	Kinematics kinematics;
+};
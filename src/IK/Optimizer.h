@@ -5,9 +5,15 @@
 
 #include "LinkObjective.h"
 
+template <int N>
 class Optimizer {
 public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	typedef typename LinkObjective<N>::Vector Vector;
+
 	Optimizer() {};
 	virtual ~Optimizer() {};
-	virtual void optimize(const LinkObjective& objective, Eigen::VectorXd& x) = 0;
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x) = 0;
+	// Number of iterations taken by the most recent call to optimize
+	virtual int getIter() const = 0;
 };
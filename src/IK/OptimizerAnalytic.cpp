@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cmath>
+
+#include "OptimizerAnalytic.h"
+#include "LinkObjective.h"
+
+namespace {
+// Wrap a single angle to the range [-pi, pi]
+double WrapAngle(const double angle) {
+	const double pi = 3.1415926535;
+	return angle - 2.0 * pi * std::floor((angle + pi) / (2.0 * pi));
+}
+} // namespace
+
+void OptimizerAnalytic::optimize(const LinkObjective<2>& objective, Vector& x) {
+	const ChainKinematics<2>& kinematics = objective.GetKinematics();
+	// Move the target into the space of the root joint (the first offset is never rotated)
+	const Eigen::Vector2d target = objective.GetTarget() -
+		Eigen::Vector2d(kinematics.GetLinkOffset(0), 0.0);
+	const Eigen::Vector2d rest(LinkObjectiveBase::GetRestAngle(0),
+	                           LinkObjectiveBase::GetRestAngle(1));
+	x = SolveAngles(kinematics.GetLinkOffset(1), kinematics.GetEndEffector(), target, rest);
+}
+
+Eigen::Vector2d OptimizerAnalytic::SolveAngles(const double link_len, const Eigen::Vector2d& r,
+                                               const Eigen::Vector2d& target,
+                                               const Eigen::Vector2d& rest_angles) {
+	// With the root at the origin, the end effector is at R(theta_0) * (a + R(theta_1) * r),
+	//   where a = [link_len, 0]. Its squared distance from the root is
+	//   |a|^2 + |r|^2 + 2 * |a| * |r| * cos(theta_1 + beta), where beta is the angle of r
+	const double a = link_len;
+	const double b = r.norm();
+	const double beta = atan2(r.y(), r.x());
+	const double dist_sq = target.squaredNorm();
+
+	// If either segment has no length, theta_1 doesn't change the reach, so just keep it at
+	//   its resting angle. Otherwise, clamp to the closest reachable distance
+	double elbow = 0.0;
+	bool has_branches = (a * b > 1e-12);
+	if (has_branches) {
+		double cos_elbow = (dist_sq - a * a - b * b) / (2.0 * a * b);
+		elbow = acos(std::min(1.0, std::max(-1.0, cos_elbow)));
+	}
+
+	// Try both elbow branches, and keep the one closest to the resting angles
+	Eigen::Vector2d best_angles(0.0, 0.0);
+	double best_cost = -1.0;
+	for (int sign = 1; sign >= -1; sign -= 2) {
+		Eigen::Vector2d angles;
+		// Total angle of r relative to link 0
+		const double phi = has_branches ? sign * elbow : rest_angles(1) + beta;
+		angles(1) = WrapAngle(phi - beta);
+		// Rotate the root so that the end effector points at the target
+		const double reach_angle = atan2(b * sin(phi), a + b * cos(phi));
+		angles(0) = WrapAngle(atan2(target.y(), target.x()) - reach_angle);
+
+		const double cost = (angles - rest_angles).squaredNorm();
+		if (best_cost < 0.0 || cost < best_cost) {
+			best_cost = cost;
+			best_angles = angles;
+		}
+		if (!has_branches) {
+			break;
+		}
+	}
+	return best_angles;
+}
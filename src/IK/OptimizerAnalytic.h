@@ -0,0 +1,33 @@
+#pragma once
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "Optimizer.h"
+#include "LinkObjective.h"
+
+///
+/// Closed-form IK for a chain with exactly 2 links. The end effector's distance from the
+/// root joint only depends on theta_1, so the law of cosines gives theta_1 directly (up
+/// to the direction of the elbow bend), then theta_0 rotates the chain to face the
+/// target. Of the 2 elbow branches, the one closer to the resting angles is chosen, using
+/// the same squared distance as LinkObjective's constraint term. Targets that are out of
+/// reach get the fully stretched (or folded) pose, pointed at the target.
+///
+/// Note: this solves the target term exactly and ignores the regularizer, so the result
+/// differs slightly from (and is closer to the target than) the iterative optimizers
+///
+class OptimizerAnalytic : public Optimizer<2> {
+public:
+	OptimizerAnalytic() = default;
+	~OptimizerAnalytic() = default;
+	// Note: ignores the starting value of x, since the solution doesn't depend on it
+	virtual void optimize(const LinkObjective<2>& objective, Vector& x);
+	virtual int getIter() const { return 1; }
+
+	// Find the angles for a 2-link chain. link_len is the offset of link 1 along link 0, r
+	//   is the end effector in link 1's space, and target is relative to the root joint.
+	//   Returned angles are wrapped to [-pi, pi]
+	static Eigen::Vector2d SolveAngles(const double link_len, const Eigen::Vector2d& r,
+	                                   const Eigen::Vector2d& target,
+	                                   const Eigen::Vector2d& rest_angles);
+};
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cmath>
+
+#include "OptimizerCCD.h"
+#include "LinkObjective.h"
+
+template <int N>
+OptimizerCCD<N>::OptimizerCCD(const int num_links) :
+	tol(1e-3),
+	iterMax(10 * num_links),
+	iter(0)
+{
+	jointPos.setZero(2, num_links);
+}
+
+template <int N>
+void OptimizerCCD<N>::optimize(const LinkObjective<N>& objective, Vector& x) {
+	const ChainKinematics<N>& kinematics = objective.GetKinematics();
+	const size_t num_links = kinematics.GetNumLinks();
+	const Eigen::Vector2d& target = objective.GetTarget();
+	const double w_tar = objective.GetTargetWeight();
+	const double w_reg = objective.GetRegularizerWeight();
+	const double w_con = objective.GetConstraintWeight();
+
+	iter = 0;
+	for (int sweep = 1; sweep <= iterMax; ++sweep) {
+		iter = sweep;
+		// Find the location of each joint and the end effector
+		double phi = 0.0;
+		Eigen::Vector2d pos(0.0, 0.0);
+		for (size_t j = 0; j < num_links; ++j) {
+			pos += kinematics.GetLinkOffset(j) * Eigen::Vector2d(cos(phi), sin(phi));
+			jointPos.col(j) = pos;
+			phi += x(j);
+		}
+		const Eigen::Vector2d& r = kinematics.GetEndEffector();
+		Eigen::Vector2d end_pos = pos + Eigen::Vector2d(cos(phi) * r.x() - sin(phi) * r.y(),
+		                                                sin(phi) * r.x() + cos(phi) * r.y());
+
+		// Rotating joint j doesn't move any joint before it, so the joint locations stay
+		//   valid as long as the sweep moves toward the root. Only the end effector moves
+		double max_step = 0.0;
+		for (int j = (int)num_links - 1; j >= 0; --j) {
+			const Eigen::Vector2d u = end_pos - jointPos.col(j);
+			const Eigen::Vector2d v = target - jointPos.col(j);
+			// Rotating by delta changes the target term by -2 * w_tar * |u||v| cos(delta - alpha),
+			//   where alpha is the angle from u to v. Minimize that plus the angle terms
+			const double alpha = atan2(u.x() * v.y() - u.y() * v.x(), u.dot(v));
+			const double k = w_tar * u.norm() * v.norm();
+			const double rest = LinkObjectiveBase::GetRestAngle(j);
+			double delta = alpha;
+			for (int step = 0; step < 3; ++step) {
+				const double angle = x(j) + delta;
+				const double d1 = k * sin(delta - alpha) + w_reg * angle + w_con * (angle - rest);
+				const double d2 = k * cos(delta - alpha) + w_reg + w_con;
+				if (d2 <= 0.0) {
+					break;
+				}
+				delta -= d1 / d2;
+			}
+
+			// Swing the end effector around joint j
+			const double cos_d = cos(delta);
+			const double sin_d = sin(delta);
+			end_pos = jointPos.col(j) + Eigen::Vector2d(cos_d * u.x() - sin_d * u.y(),
+			                                            sin_d * u.x() + cos_d * u.y());
+			x(j) += delta;
+			max_step = std::max(max_step, std::abs(delta));
+		}
+
+		if (max_step < tol) {
+			break;
+		}
+	}
+}
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class OptimizerCCD<2>;
+template class OptimizerCCD<3>;
+template class OptimizerCCD<4>;
+template class OptimizerCCD<5>;
+template class OptimizerCCD<6>;
+template class OptimizerCCD<7>;
+template class OptimizerCCD<Eigen::Dynamic>;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "Optimizer.h"
+#include "LinkObjective.h"
+
+///
+/// Cyclic coordinate descent. Each sweep visits the joints from the end of the chain back
+/// to the root, and rotates each one to minimize the objective with every other angle held
+/// still. Rotating joint j swings the end effector in a circle about joint j, so the target
+/// term only depends on the angle between (joint -> end effector) and (joint -> target),
+/// which makes each 1D problem cheap to solve: start from the rotation that points the end
+/// effector at the target (classic CCD), then take a few newton steps to account for the
+/// regularizer and rest angle terms. A sweep costs O(n), with no matrices at all.
+///
+template <int N>
+class OptimizerCCD : public Optimizer<N> {
+public:
+	typedef typename Optimizer<N>::Vector Vector;
+
+	OptimizerCCD(const int num_links);
+	~OptimizerCCD() = default;
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x);
+
+	void setTol(double tol) { this->tol = tol; }
+	void setIterMax(int iterMax) { this->iterMax = iterMax; }
+	virtual int getIter() const { return iter; }
+
+private:
+	// Stop once a sweep rotates no joint by more than this (in radians)
+	double tol;
+	// Max number of sweeps
+	int iterMax;
+	int iter;
+	// Location of each joint, in chain space. Kept between calls so that dynamic-size chains
+	//   don't reallocate
+	Eigen::Matrix<double, 2, N> jointPos;
+};
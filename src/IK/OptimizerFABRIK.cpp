@@ -0,0 +1,113 @@
+#include <cmath>
+
+#include "OptimizerFABRIK.h"
+#include "LinkObjective.h"
+
+namespace {
+// Wrap an angle to the range [-pi, pi]
+double WrapAngle(double angle) {
+	const double pi = 3.1415926535;
+	return angle - 2.0 * pi * std::floor((angle + pi) / (2.0 * pi));
+}
+
+// Unit vector from 'from' toward 'to'. Falls back to 'fallback' if the points overlap
+Eigen::Vector2d Direction(const Eigen::Vector2d& from, const Eigen::Vector2d& to,
+                          const Eigen::Vector2d& fallback) {
+	const Eigen::Vector2d diff = to - from;
+	const double len = diff.norm();
+	return (len > 1e-12) ? Eigen::Vector2d(diff / len) : fallback;
+}
+} // namespace
+
+template <int N>
+OptimizerFABRIK<N>::OptimizerFABRIK(const int num_links) :
+	tol(1e-3),
+	iterMax(10 * num_links),
+	iter(0)
+{
+	points.setZero(2, num_links + 1);
+	lengths.setZero(num_links);
+}
+
+template <int N>
+void OptimizerFABRIK<N>::optimize(const LinkObjective<N>& objective, Vector& x) {
+	const ChainKinematics<N>& kinematics = objective.GetKinematics();
+	const int num_links = (int)kinematics.GetNumLinks();
+	const Eigen::Vector2d& target = objective.GetTarget();
+	const Eigen::Vector2d& r = kinematics.GetEndEffector();
+	// The last segment points along r, which may not line up with the last link's x axis
+	const double r_angle = atan2(r.y(), r.x());
+	const double w_tar = objective.GetTargetWeight();
+	const double w_reg = objective.GetRegularizerWeight();
+	const double w_con = objective.GetConstraintWeight();
+	const double pull = (w_reg + w_con) / (w_tar + w_reg + w_con);
+
+	// Place every point using the current angles, so the solve is warm-started
+	double phi = 0.0;
+	Eigen::Vector2d pos(0.0, 0.0);
+	for (int j = 0; j < num_links; ++j) {
+		pos += kinematics.GetLinkOffset(j) * Eigen::Vector2d(cos(phi), sin(phi));
+		points.col(j) = pos;
+		lengths(j) = (j + 1 < num_links) ? kinematics.GetLinkOffset(j + 1) : r.norm();
+		phi += x(j);
+	}
+	points.col(num_links) = pos + Eigen::Vector2d(cos(phi) * r.x() - sin(phi) * r.y(),
+	                                              sin(phi) * r.x() + cos(phi) * r.y());
+	const Eigen::Vector2d root = points.col(0);
+
+	iter = 0;
+	for (int it = 1; it <= iterMax; ++it) {
+		iter = it;
+		const Eigen::Vector2d prev_end = points.col(num_links);
+
+		// Backward pass: pin the end effector to the target and work toward the root
+		points.col(num_links) = target;
+		for (int j = num_links - 1; j >= 0; --j) {
+			const Eigen::Vector2d next = points.col(j + 1);
+			points.col(j) = next + lengths(j) *
+				Direction(next, points.col(j), Eigen::Vector2d(-1.0, 0.0));
+		}
+
+		// Forward pass: pin the root and work back out, pulling each segment toward its
+		//   preferred angle relative to the previous segment
+		points.col(0) = root;
+		double prev_angle = 0.0;
+		for (int j = 0; j < num_links; ++j) {
+			const Eigen::Vector2d cur = points.col(j);
+			const Eigen::Vector2d dir = Direction(cur, points.col(j + 1),
+				Eigen::Vector2d(cos(prev_angle), sin(prev_angle)));
+			double angle = atan2(dir.y(), dir.x());
+			const double offset = (j + 1 == num_links) ? r_angle : 0.0;
+			const double preferred = prev_angle + offset +
+				w_con * LinkObjectiveBase::GetRestAngle(j) / (w_reg + w_con);
+			angle += pull * WrapAngle(preferred - angle);
+			points.col(j + 1) = cur + lengths(j) * Eigen::Vector2d(cos(angle), sin(angle));
+			prev_angle = angle;
+		}
+
+		if ((points.col(num_links) - prev_end).norm() < tol) {
+			break;
+		}
+	}
+
+	// Convert the segment directions back to relative angles. Zero-length segments have
+	//   no direction, so those links keep their previous angle
+	double prev_angle = 0.0;
+	for (int j = 0; j < num_links; ++j) {
+		const double offset = (j + 1 == num_links) ? r_angle : 0.0;
+		if (lengths(j) > 1e-12) {
+			const Eigen::Vector2d seg = points.col(j + 1) - points.col(j);
+			x(j) = WrapAngle(atan2(seg.y(), seg.x()) - offset - prev_angle);
+		}
+		prev_angle += x(j);
+	}
+}
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class OptimizerFABRIK<2>;
+template class OptimizerFABRIK<3>;
+template class OptimizerFABRIK<4>;
+template class OptimizerFABRIK<5>;
+template class OptimizerFABRIK<6>;
+template class OptimizerFABRIK<7>;
+template class OptimizerFABRIK<Eigen::Dynamic>;
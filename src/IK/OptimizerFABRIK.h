@@ -0,0 +1,46 @@
+#pragma once
+
+#include <eigen-3.4.0/Eigen/Dense>
+
+#include "ChainKinematics.h"
+#include "Optimizer.h"
+#include "LinkObjective.h"
+
+///
+/// Forward And Backward Reaching IK. Works on joint positions instead of angles: the
+/// backward pass pins the end effector to the target and drags each joint toward it, and
+/// the forward pass pins the root back in place and drags each joint back out, keeping
+/// every segment at its original length. Each pass is O(n) with no trig besides the final
+/// conversion back to angles.
+///
+/// Plain FABRIK has no notion of a preferred pose, so the forward pass also turns each
+/// segment part of the way toward its preferred angle relative to the previous segment
+/// (the angle that minimizes the objective's regularizer and rest angle terms). The pull
+/// is the share of the objective's weight that those terms hold. That only approximates
+/// the objective, so the result settles near the newton solvers' compromise but not on it
+/// (IKBenchmark reports the gap in the objective).
+///
+template <int N>
+class OptimizerFABRIK : public Optimizer<N> {
+public:
+	typedef typename Optimizer<N>::Vector Vector;
+
+	OptimizerFABRIK(const int num_links);
+	~OptimizerFABRIK() = default;
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x);
+
+	void setTol(double tol) { this->tol = tol; }
+	void setIterMax(int iterMax) { this->iterMax = iterMax; }
+	virtual int getIter() const { return iter; }
+
+private:
+	// Stop once an iteration moves the end effector less than this (in J-space units)
+	double tol;
+	int iterMax;
+	int iter;
+	// Location of each joint followed by the end effector, and the length of the segment
+	//   from each of those points to the next. Kept between calls so that dynamic-size
+	//   chains don't reallocate
+	Eigen::Matrix<double, 2, ChainKinematics<N>::NUM_SEGMENTS> points;
+	Vector lengths;
+};
@@ -3,20 +3,21 @@
 #include "OptimizerGDLS.h"
 #include "LinkObjective.h"
 
-OptimizerGDLS::OptimizerGDLS(const int num_links) :
+template <int N>
+OptimizerGDLS<N>::OptimizerGDLS(const int num_links) :
 	alphaInit(1.0),
 	gamma(0.25),
 	tol(2e-1),
 	iterMax(5 * num_links),
 	iter(0)
 {
-	
+	g.setZero(num_links);
+	dx.setZero(num_links);
+	xNew.setZero(num_links);
 }
 
-void OptimizerGDLS::optimize(const LinkObjective& objective, Eigen::VectorXd& x) {
-	int n = x.rows();
-	Eigen::VectorXd g(n);
-	Eigen::VectorXd dx(n);
+template <int N>
+void OptimizerGDLS<N>::optimize(const LinkObjective<N>& objective, Vector& x) {
 	iter = 0;
 	for (size_t i = 1; i <= iterMax; ++i) {
 		// Evaluate f and g
@@ -26,7 +27,8 @@ void OptimizerGDLS::optimize(const LinkObjective& objective, Eigen::VectorXd& x)
 		for (size_t j = 1; j < iterMax; ++j) {
 			// Test the function at the new location, and reduce alpha if it is not smaller
 			dx = -1.0 * alpha * g;
-			double fNew = objective.evalObjective(x + dx);
+			xNew = x + dx;
+			double fNew = objective.evalObjective(xNew);
 			if (fNew < f) {
 				// The current alpha value works
 				break;
@@ -43,3 +45,12 @@ void OptimizerGDLS::optimize(const LinkObjective& objective, Eigen::VectorXd& x)
 		}
 	}
 }
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class OptimizerGDLS<2>;
+template class OptimizerGDLS<3>;
+template class OptimizerGDLS<4>;
+template class OptimizerGDLS<5>;
+template class OptimizerGDLS<6>;
+template class OptimizerGDLS<7>;
+template class OptimizerGDLS<Eigen::Dynamic>;
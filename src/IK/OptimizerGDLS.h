@@ -3,17 +3,20 @@
 #include "Optimizer.h"
 #include "LinkObjective.h"
 
-class OptimizerGDLS : public Optimizer {
+template <int N>
+class OptimizerGDLS : public Optimizer<N> {
 public:
+	typedef typename Optimizer<N>::Vector Vector;
+
 	OptimizerGDLS(const int num_links);
 	~OptimizerGDLS() = default;
-	virtual void optimize(const LinkObjective& objective, Eigen::VectorXd& x);
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x);
 	
 	void setAlphaInit(double alphaInit) { this->alphaInit = alphaInit; }
 	void setGamma(double gamma) { this->gamma = gamma; }
 	void setTol(double tol) { this->tol = tol; }
 	void setIterMax(int iterMax) { this->iterMax = iterMax; }
-	int getIter() const { return iter; }
+	virtual int getIter() const { return iter; }
 	
 private:
 	double alphaInit;
@@ -21,4 +24,9 @@ private:
 	double tol;
 	int iterMax;
 	int iter;
+	// Scratch space for the gradient, step and trial point, kept between calls so that
+	//   dynamic-size chains don't reallocate on every optimization
+	Vector g;
+	Vector dx;
+	Vector xNew;
 };
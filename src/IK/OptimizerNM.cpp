@@ -1,31 +1,102 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "LinkObjective.h"
 #include "OptimizerNM.h"
 
 
-OptimizerNM::OptimizerNM(const int num_links) :
-	tol(2e-1),
+template <int N>
+OptimizerNM<N>::OptimizerNM(const int num_links) :
+	tol(1e-3),
 	iterMax(5 * num_links),
-	iter(0)
+	iter(0),
+	dampingInit(1e-3),
+	trustRadiusInit(0.5),
+	ldlt(num_links)
 {
-	
+	g.setZero(num_links);
+	H.setZero(num_links, num_links);
+	HDamped.setZero(num_links, num_links);
+	dx.setZero(num_links);
+	Hdx.setZero(num_links);
+	xNew.setZero(num_links);
 }
 
-void OptimizerNM::optimize(const LinkObjective& objective, Eigen::VectorXd& x) {
-	int n = x.rows();
-	Eigen::VectorXd g(n);
-	Eigen::MatrixXd H(n, n);
+template <int N>
+void OptimizerNM<N>::optimize(const LinkObjective<N>& objective, Vector& x) {
 	iter = 0;
-	for (size_t i = 1; i < iterMax; ++i) {
-		// Evaluate f, g, and H
-		double f = objective.evalObjective(x, &g, &H);
-		Eigen::VectorXd dx = -1.0 * H.inverse() * g;
-		x += dx;
-
-		if (dx.norm() < tol) {
-			iter = i;
-			break;
+	// Evaluate f, g, and H at the starting point
+	double f = objective.evalObjective(x, &g, &H);
+	double lambda = dampingInit * std::max(H.diagonal().cwiseAbs().maxCoeff(), 1.0);
+	double radius = trustRadiusInit;
+	// Factor to raise lambda by after a failed step. Doubles on consecutive failures
+	double nu = 2.0;
+
+	for (size_t i = 1; i <= iterMax; ++i) {
+		iter = i;
+		// Damp the Hessian. If it still isn't positive definite, the step might not be a
+		//   descent direction, so keep raising the damping until it is
+		HDamped = H;
+		HDamped.diagonal().array() += lambda;
+		ldlt.compute(HDamped);
+		if (ldlt.info() != Eigen::Success || (ldlt.vectorD().array() <= 0.0).any()) {
+			lambda *= nu;
+			nu *= 2.0;
+			continue;
+		}
+		dx = ldlt.solve(g);
+		dx *= -1.0;
+
+		// Keep the step inside the trust region
+		double step_len = dx.norm();
+		if (step_len > radius) {
+			dx *= radius / step_len;
+			step_len = radius;
+		}
+
+		// Compare the actual reduction with the reduction predicted by the quadratic model
+		Hdx.noalias() = H * dx;
+		double predicted = -1.0 * (g.dot(dx) + 0.5 * dx.dot(Hdx));
+		xNew = x + dx;
+		double fNew = objective.evalObjective(xNew);
+		double rho = (predicted > 0.0) ? (f - fNew) / predicted : -1.0;
+
+		if (rho > 0.0) {
+			// The step reduced f, so take it. The better the model's prediction was, the
+			//   less damping (and the larger the trust region) the next step gets
+			x = xNew;
+			f = objective.evalObjective(x, &g, &H);
+			double scale = 2.0 * rho - 1.0;
+			lambda *= std::max(1.0 / 3.0, 1.0 - scale * scale * scale);
+			nu = 2.0;
+			if (rho > 0.75) {
+				radius = std::max(radius, 2.0 * step_len);
+			}
+			else if (rho < 0.25) {
+				radius *= 0.5;
+			}
+			if (step_len < tol) {
+				break;
+			}
+		}
+		else {
+			// The step made things worse, so shrink it and try again from the same point
+			lambda *= nu;
+			nu *= 2.0;
+			radius = 0.5 * step_len;
+			if (radius < tol) {
+				break;
+			}
 		}
 	}
 }
+
+// Instantiate every chain size that ChainSolver::Create can choose
+template class OptimizerNM<2>;
+template class OptimizerNM<3>;
+template class OptimizerNM<4>;
+template class OptimizerNM<5>;
+template class OptimizerNM<6>;
+template class OptimizerNM<7>;
+template class OptimizerNM<Eigen::Dynamic>;
@@ -5,20 +5,49 @@
 #include "Optimizer.h"
 #include "LinkObjective.h"
 
-class OptimizerNM : public Optimizer {
+///
+/// Damped newton's method (Levenberg-Marquardt style). Each step solves
+/// (H + lambda * I) * dx = -g with an LDLT factorization, where the damping lambda is
+/// raised until the system is positive definite, so the step always heads downhill even
+/// near singular poses. Steps are clamped to a trust region, and are only accepted if
+/// they actually reduce the objective. The ratio of the actual to the predicted reduction
+/// adapts both lambda and the trust radius for the next step.
+///
+template <int N>
+class OptimizerNM : public Optimizer<N> {
 public:
+	typedef typename Optimizer<N>::Vector Vector;
+	typedef typename LinkObjective<N>::Hessian Hessian;
+
 	OptimizerNM(const int num_links);
 	~OptimizerNM() = default;
-	virtual void optimize(const LinkObjective& objective, Eigen::VectorXd& x);
+	virtual void optimize(const LinkObjective<N>& objective, Vector& x);
 	
 	void setTol(double tol) { this->tol = tol; }
 	void setIterMax(int iterMax) { this->iterMax = iterMax; }
-	int getIter() const { return iter; }
+	void setDampingInit(double dampingInit) { this->dampingInit = dampingInit; }
+	void setTrustRadiusInit(double trustRadiusInit) { this->trustRadiusInit = trustRadiusInit; }
+	virtual int getIter() const { return iter; }
 	
 private:
+	// Stop once a step (in radians) is smaller than this
 	double tol;
 	int iterMax;
 	int iter;
+	// Starting damping, relative to the largest diagonal entry of H
+	double dampingInit;
+	// Starting max step length, in radians
+	double trustRadiusInit;
+	// Scratch space for the gradient, Hessian and step, kept between calls so that
+	//   dynamic-size chains don't reallocate on every optimization
+	Vector g;
+	Hessian H;
+	Hessian HDamped;
+	Vector dx;
+	Vector Hdx;
+	Vector xNew;
+	// Factorization of the damped Hessian, used to solve for the step without inverting H
+	Eigen::LDLT<Hessian> ldlt;
 };
 
 #endif
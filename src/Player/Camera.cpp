@@ -9,18 +9,11 @@
 Camera::Camera(std::weak_ptr<GameEngine> engine, const std::string& name) :
 	SceneObject(engine, name) {
 	UpdateProjectionMtx();
-	UpdateViewMtx();
+	UpdateOrbitMtx();
 }
 
 void Camera::BeginPlay() {}
 
-void Camera::PhysicsUpdate(const float delta_time) {
-	// Do the same as the SceneObject physicsupdate, but also update the view
-	//   matrix afterward to get any updates to this camera's transform
-	SceneObject::PhysicsUpdate(delta_time);
-	UpdateViewMtx();
-}
-
 void Camera::Render(const std::shared_ptr<ShaderProgram> shader) const {
 	SceneObject::Render(shader);
 	// TODO: define a quick visualization for cameras, but don't draw this
@@ -43,15 +36,18 @@ void Camera::ApplyRotationInput(const glm::vec2& input) {
 	else if (armAngle.x <= -1.0f * maxVerticalAngle) {
 		armAngle.x = -1.0f * maxVerticalAngle;
 	}
-	UpdateViewMtx();
+	UpdateOrbitMtx();
 }
 
 const glm::mat4& Camera::GetProjectionMtx() const {
 	return projectionMtx;
 }
 
-const glm::mat4& Camera::GetViewMtx() const {
-	return viewMtx;
+glm::mat4 Camera::GetViewMtx() const {
+	// Find the total transformation matrix from world space -> camera orbit view space.
+	// Note that this is the opposite order from going local -> world, since
+	//   the view matrix defines a world -> local transformation
+	return orbitMtx * glm::inverse(GetRenderTransformMtx());
 }
 
 void Camera::SetFovDegrees(const float new_fov) {
@@ -71,32 +67,33 @@ void Camera::SetAspectRatio(const float new_aspect) {
 
 void Camera::SetArmLength(const float new_length) {
 	armLength = new_length;
-	UpdateViewMtx();
+	UpdateOrbitMtx();
 }
 
 void Camera::SetArmAngleDegrees(const glm::vec2 new_angle) {
 	armAngle.x = glm::radians(new_angle.x);
 	armAngle.y = glm::radians(new_angle.y);
-	UpdateViewMtx();
+	UpdateOrbitMtx();
 }
 
 void Camera::SetArmAngleRadians(const glm::vec2 new_angle) {
 	armAngle = new_angle;
-	UpdateViewMtx();
+	UpdateOrbitMtx();
 }
 
 void Camera::UpdateProjectionMtx() {
 	projectionMtx = glm::perspective(fovY, aspectRatio, clipNear, clipFar);
 }
 
-void Camera::UpdateViewMtx() {
+void Camera::UpdateOrbitMtx() {
 	// Note: there are 3 coordinate spaces in play here.
 	//   World space: coordinate space of the scene
-	//   Local space: coordinate space of the rootComponent, set by the rootTransform
+	//   Local space: coordinate space of the rootComponent, set by the relative transform
 	//     inherited from the SceneObject class
 	//   Orbit space: coordinate space of the camera view, set by the armLength and
 	//     armAngle
-	// To get the viewMtx, we need a transformation matrix from world -> orbit space
+	// To get the view matrix, we need a transformation matrix from world -> orbit space.
+	//   This function finds the local -> orbit part, and GetViewMtx adds world -> local
 
 	// Set the local-space location of the camera view based on the arm length & rotation
 	glm::vec3 viewPos;
@@ -106,11 +103,5 @@ void Camera::UpdateViewMtx() {
 	
 	// Using the local-space camera location, find a transformation matrix from the
 	//   the rootComponent space -> camera's orbit view space
-	glm::mat4 orbitMtx;
 	orbitMtx = glm::lookAt(viewPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-	
-	// Find the total transformation matrix from world space -> camera orbit view space.
-	// Note that this is the opposite order from going local -> world, since
-	//   the view matrix defines a world -> local transformation
-	viewMtx = orbitMtx * glm::inverse(modelMtx);
 }
@@ -18,7 +18,6 @@ public:
 
 	// Override functions from SceneObject class
 	virtual void BeginPlay() override;
-	virtual void PhysicsUpdate(const float delta_time) override;
 	virtual void Render(const std::shared_ptr<ShaderProgram> shader) const override;
 
 	/* ----- Player Inputs ----- */
@@ -26,7 +25,8 @@ public:
 
 	/* ----- Getters ----- */
 	const glm::mat4& GetProjectionMtx() const;
-	const glm::mat4& GetViewMtx() const;
+	// Built from the camera's render transform, so it follows the interpolated scene
+	glm::mat4 GetViewMtx() const;
 
 	/* ----- Setters ----- */
 	void SetFovDegrees(const float new_fov);
@@ -57,11 +57,11 @@ private:
 	// Maximum value of armAngle.x (must be LESS than pi/2)
 	const float maxVerticalAngle = (glm::pi<float>() / 2.0f) - 0.2f;
 
-	// Store the projection and view matrices on this camera object
+	// Store the projection and orbit matrices on this camera object
 	glm::mat4 projectionMtx;
-	// Note: the view matrix is stored in WORLD space, so it can be accessed directly
-	//   by shaders
-	glm::mat4 viewMtx;
+	// Transformation from the camera's local space to its orbit view space. Only depends
+	//   on the arm, so it's rebuilt when the arm changes instead of every physics step
+	glm::mat4 orbitMtx;
 	void UpdateProjectionMtx();
-	void UpdateViewMtx();
+	void UpdateOrbitMtx();
 };
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cassert>
+#include <sstream>
 
 #include <glm/glm.hpp>
 
@@ -8,6 +9,7 @@
 #include "../Rendering/ShaderProgram.h"
 #include "../Utils/Transform.h"
 #include "../IK/IKChain.h"
+#include "../IK/LegSolverBatch.h"
 #include "../IK/LegTarget.h"
 
 SpiderCharacter::SpiderCharacter(std::weak_ptr<GameEngine> engine, const std::string& name,
@@ -15,15 +17,19 @@ SpiderCharacter::SpiderCharacter(std::weak_ptr<GameEngine> engine, const std::st
 	const size_t legs_per_side, const size_t links_per_chain,
 	const glm::vec3 leg_pos, const glm::vec3 target_pos,
 	const bool render_links, const bool render_leg_targets,
-	const float target_threshold, const float target_lerp_time) :
+	const float target_threshold, const float target_lerp_time,
+	const IKSettings& ik_settings) :
 	SceneObject(engine, name),
 	moveSpeed(move_speed), turnSpeed(turn_speed),
 	legsPerSide(legs_per_side), linksPerChain(links_per_chain),
 	legPos(leg_pos), targetPos(target_pos),
 	renderLinks(render_links), renderLegTargets(render_leg_targets),
-	targetThreshold(target_threshold), targetLerpTime(target_lerp_time)
+	targetThreshold(target_threshold), targetLerpTime(target_lerp_time),
+	ikSettings(ik_settings)
 {}
 
+SpiderCharacter::~SpiderCharacter() = default;
+
 void SpiderCharacter::BeginPlay() {
 	// Create the legs
 	const std::string sides[2] = { "L", "R" };
@@ -46,7 +52,7 @@ void SpiderCharacter::BeginPlay() {
 			// Name has format 'leg_L_0', 'leg_R_1_target' etc.
 			auto new_leg_chain = std::make_shared<IKChain>(engineRef,
 				"leg_" + sides[j] + "_" + std::to_string(i),
-				linksPerChain, renderLinks);
+				linksPerChain, renderLinks, ikSettings.method);
 			auto new_leg_target = std::make_shared<LegTarget>(engineRef,
 				"leg_" + sides[j] + "_" + std::to_string(i) + "_target",
 				renderLegTargets, targetThreshold, targetLerpTime);
@@ -81,7 +87,26 @@ void SpiderCharacter::BeginPlay() {
 
 	// Manually call BeginPlay on child objects, since they aren't being managed by the Scene
 	for (auto& child : childObjects) {
-		child.lock()->BeginPlay();
+		child->BeginPlay();
+	}
+	for (auto& leg : legList) {
+		leg.first->SetTargetEpsilon(ikSettings.targetEpsilon);
+	}
+
+	// Hand the legs' IK over to a single batch solver. This must happen after the chains'
+	//   BeginPlay, since that's where their links are created
+	const bool can_batch = ikSettings.method == ChainSolver::Method::Auto ||
+		ikSettings.method == ChainSolver::Method::Newton;
+	if (ikSettings.batchLegIK && can_batch && !legList.empty()) {
+		const std::shared_ptr<IKChain>& first_chain = legList.front().first;
+		legSolver = std::make_unique<LegSolverBatch>(legList.size(),
+			first_chain->GetLinkOffsets(), first_chain->GetEndEffectorPos().head<2>(),
+			ikSettings.method);
+		legSolver->SetTargetEpsilon(ikSettings.targetEpsilon);
+		for (size_t i = 0; i < legList.size(); ++i) {
+			legList.at(i).first->SetSolvedExternally(true);
+			legSolver->SetAngles(i, legList.at(i).first->GetLinkAngles());
+		}
 	}
 	
 	// Mark physics dirty to trigger the legs to start calculating their positions
@@ -91,18 +116,25 @@ void SpiderCharacter::BeginPlay() {
 
 void SpiderCharacter::PhysicsUpdate(const float delta_time) {
 	// Rotation from input
-	rootTransform.AddRotationOffset(GetAngularSpeed() * delta_time,
-	                                glm::vec3(0.0f, 1.0f, 0.0f));
-	rootTransform.loc += GetLinearVelocity() * delta_time;
+	Transform& root_transform = GetMutableRelativeTransform();
+	root_transform.AddRotationOffset(GetAngularSpeed() * delta_time,
+	                                 glm::vec3(0.0f, 1.0f, 0.0f));
+	root_transform.loc += GetLinearVelocity() * delta_time;
 	MarkPhysicsDirty();
+	if (legSolver) {
+		SolveLegsBatched();
+	}
 	SceneObject::PhysicsUpdate(delta_time);
+	if (ikSettings.showIKStats) {
+		PrintIKStats();
+	}
 }
 
 void SpiderCharacter::Render(const std::shared_ptr<ShaderProgram> shader) const {
 	SceneObject::Render(shader);
 	// Manually call Render on child objects, since they aren't being managed by the Scene
 	for (auto& child : childObjects) {
-		child.lock()->Render(shader);
+		child->Render(shader);
 	}
 }
 
@@ -111,17 +143,17 @@ glm::vec3 SpiderCharacter::GetLinearVelocity() const {
 	glm::vec3 total_velocity(0.0f);
 	// Foward/Backward input
 	if (engine->IsKeyPressed(GLFW_KEY_W)) {
-		total_velocity += rootTransform.GetForwardVector();
+		total_velocity += GetRelativeTransform().GetForwardVector();
 	}
 	else if (engine->IsKeyPressed(GLFW_KEY_S)) {
-		total_velocity -= rootTransform.GetForwardVector();
+		total_velocity -= GetRelativeTransform().GetForwardVector();
 	}
 	// Side to side input
 	if (engine->IsKeyPressed(GLFW_KEY_A)) {
-		total_velocity += rootTransform.GetRightVector();
+		total_velocity += GetRelativeTransform().GetRightVector();
 	}
 	else if (engine->IsKeyPressed(GLFW_KEY_D)) {
-		total_velocity -= rootTransform.GetRightVector();
+		total_velocity -= GetRelativeTransform().GetRightVector();
 	}
 	total_velocity *= moveSpeed;
 	return total_velocity;
@@ -140,6 +172,50 @@ float SpiderCharacter::GetAngularSpeed() const {
 	else return 0.0f;
 }
 
+void SpiderCharacter::SolveLegsBatched() {
+	// Note: like the per-chain path, this uses the chains' & targets' transforms from the
+	//   previous tick, since they're updated afterward in SceneObject::PhysicsUpdate
+	for (size_t i = 0; i < legList.size(); ++i) {
+		legSolver->SetTarget(i, legList.at(i).first->AimAtTarget());
+	}
+	legSolver->Solve();
+	Eigen::VectorXd angles;
+	for (size_t i = 0; i < legList.size(); ++i) {
+		legSolver->GetAngles(i, angles);
+		legList.at(i).first->SetLinkAngles(angles);
+	}
+}
+
+void SpiderCharacter::PrintIKStats() const {
+	size_t num_hits = legSolver ? legSolver->GetNumCacheHits() : 0;
+	size_t num_misses = legSolver ? legSolver->GetNumCacheMisses() : 0;
+	// Build the whole line first, since spiders update in parallel and separate writes to
+	//   std::cout could interleave
+	std::ostringstream line;
+	line << "IK stats (" << objectName << "):";
+	for (size_t i = 0; i < legList.size(); ++i) {
+		const std::shared_ptr<IKChain>& chain = legList.at(i).first;
+		ChainSolver::SolveStats stats;
+		if (legSolver) {
+			stats = legSolver->GetStats(i);
+		}
+		else {
+			stats = chain->GetSolver().GetLastStats();
+			num_hits += chain->GetSolver().GetNumCacheHits();
+			num_misses += chain->GetSolver().GetNumCacheMisses();
+		}
+		line << " " << chain->GetName() << " ";
+		if (stats.cacheHit) {
+			line << "cached;";
+		}
+		else {
+			line << stats.iterations << " iters, " << stats.timeUs << " us;";
+		}
+	}
+	line << " cache hits: " << num_hits << ", misses: " << num_misses << "\n";
+	std::cout << line.str() << std::flush;
+}
+
 inline void SpiderCharacter::MakeLegNeighbors(size_t index_1, size_t index_2) {
 	assert(index_1 < legList.size() && index_2 < legList.size());
 	legList.at(index_1).second->AddNeighbor(legList.at(index_2).second);
@@ -5,10 +5,12 @@
 #include <utility>
 #include <vector>
 
+#include "../IK/ChainSolver.h"
 #include "../Rendering/SceneObject.h"
 class ShaderProgram;
 class GameEngine;
 class IKChain;
+class LegSolverBatch;
 class LegTarget;
 
 ///
@@ -16,6 +18,21 @@ class LegTarget;
 ///
 class SpiderCharacter : public SceneObject {
 public:
+	// Settings for how the legs' IK is solved
+	struct IKSettings {
+		// Should the legs be solved together by a LegSolverBatch, instead of by each IKChain?
+		//   Only the Auto and Newton methods can be batched, so any other method always
+		//   solves each leg on its own
+		bool batchLegIK = true;
+		// Which optimizer each leg uses
+		ChainSolver::Method method = ChainSolver::Method::Auto;
+		// Should each leg's solver iterations & time be printed to stdout every physics tick?
+		bool showIKStats = false;
+		// Legs whose targets move less than this (in J-space) since their last solve reuse
+		//   the previous result instead of solving again
+		double targetEpsilon = 1e-4;
+	};
+
 	// TODO: this is too many parameters, back into structs for ChainSettings and
 	//   LegSettings
 	SpiderCharacter(std::weak_ptr<GameEngine> engine, const std::string& name,
@@ -23,8 +40,10 @@ public:
 		const size_t legs_per_side, const size_t links_per_chain,
 		const glm::vec3 leg_pos, const glm::vec3 target_pos,
 		const bool render_links, const bool render_leg_targets,
-		const float target_threshold, const float target_lerp_time);
-	~SpiderCharacter() = default;
+		const float target_threshold, const float target_lerp_time,
+		const IKSettings& ik_settings);
+	// Note: defined in the cpp, where LegSolverBatch is a complete type
+	~SpiderCharacter();
 
 	virtual void BeginPlay() override;
 	virtual void PhysicsUpdate(const float delta_time) override;
@@ -39,6 +58,12 @@ public:
 private:
 	// Make 2 LegTargets in the legList neighbors of each other
 	inline void MakeLegNeighbors(size_t index_1, size_t index_2);
+	// Aim every leg at its target, solve all of the legs' IK together, then send the
+	//   resulting angles back to the chains
+	void SolveLegsBatched();
+	// Print the iteration count & solve time of each leg's most recent solve, along with
+	//   the total number of solves that were skipped/run
+	void PrintIKStats() const;
 
 	// Settings for generating legs and legtargets
 	const size_t legsPerSide = 3;
@@ -49,9 +74,13 @@ private:
 	const bool renderLegTargets = false;
 	const float targetThreshold = 0.6;
 	const float targetLerpTime = 0.1;
+	const IKSettings ikSettings;
 
 	// Keep a list of legs & target that the SpiderObject controls (NOT controlled by the scene)
 	std::vector<std::pair<std::shared_ptr<IKChain>, std::shared_ptr<LegTarget> > > legList;
+	// Solves the IK for every leg in legList at once (only created if ikSettings.batchLegIK
+	//   is set)
+	std::unique_ptr<LegSolverBatch> legSolver;
 	// Distance to cover per physics frame
 	const float moveSpeed = 2.0f;
 	// Amount to rotate about this object's y axis per frame
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <iostream>
+
+#include "../AssetImport/StaticMesh.h"
+#include "MeshArena.h"
+#include "RenderQueue.h"
+
+MeshArena::MeshArena(const VertexFormat vertex_format, const GLuint instance_buffer,
+                     const GLuint vertex_capacity, const GLuint index_capacity) :
+	vertexFormat(vertex_format),
+	vertexSize(GetVertexSize(vertex_format)),
+	instanceBuffer(instance_buffer),
+	vertexRanges(vertex_capacity),
+	indexRanges(index_capacity)
+{
+	glGenVertexArrays(1, &vertexArrayID);
+	glGenBuffers(1, &vertexBufferID);
+	glGenBuffers(1, &elementBufferID);
+	// Allocate the storage without filling it. Meshes are copied in with glBufferSubData
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, vertex_capacity * vertexSize, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_capacity * sizeof(GLuint), nullptr,
+	             GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	SetupVertexArray();
+}
+
+MeshArena::~MeshArena() {
+	glDeleteVertexArrays(1, &vertexArrayID);
+	glDeleteBuffers(1, &vertexBufferID);
+	glDeleteBuffers(1, &elementBufferID);
+}
+
+MeshArena::Allocation MeshArena::Allocate(const void* vertices, const GLuint num_vertices,
+                                          const GLuint* indices, const GLuint num_indices) {
+	Allocation allocation;
+	allocation.numVertices = num_vertices;
+	allocation.numIndices = num_indices;
+	allocation.firstVertex = AllocateRange(vertexRanges, vertexBufferID,
+	                                       allocation.numVertices, vertexSize);
+	allocation.firstIndex = AllocateRange(indexRanges, elementBufferID,
+	                                      allocation.numIndices, sizeof(GLuint));
+
+	// Note: the element buffer is written through GL_COPY_WRITE_BUFFER, since binding it
+	//   to GL_ELEMENT_ARRAY_BUFFER would change whichever vertex array is bound
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+	glBufferSubData(GL_ARRAY_BUFFER, allocation.firstVertex * vertexSize,
+	                num_vertices * vertexSize, vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, elementBufferID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.firstIndex * sizeof(GLuint),
+	                num_indices * sizeof(GLuint), indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return allocation;
+}
+
+void MeshArena::Free(const Allocation& allocation) {
+	vertexRanges.Free(allocation.firstVertex, allocation.numVertices);
+	indexRanges.Free(allocation.firstIndex, allocation.numIndices);
+}
+
+size_t MeshArena::GetVertexSize(const VertexFormat format) {
+	return (format == VertexFormat::PACKED) ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+DrawElementsIndirectCommand MeshArena::MakeDrawCommand(const Allocation& allocation,
+                                                       const GLuint base_instance,
+                                                       const GLuint num_instances) {
+	DrawElementsIndirectCommand command;
+	command.count = allocation.numIndices;
+	command.instanceCount = num_instances;
+	command.firstIndex = allocation.firstIndex;
+	command.baseVertex = (GLint)allocation.firstVertex;
+	command.baseInstance = base_instance;
+	return command;
+}
+
+GLuint MeshArena::AllocateRange(RangeAllocator& allocator, GLuint& buffer, const GLuint size,
+                                const size_t element_size) {
+	GLuint offset = 0;
+	if (size == 0 || allocator.Allocate(size, offset)) {
+		return offset;
+	}
+
+	/* ----- Out of room, so move everything to a bigger buffer ----- */
+	const GLuint old_capacity = allocator.GetCapacity();
+	const GLuint new_capacity = std::max(2 * old_capacity, old_capacity + size);
+	GLuint new_buffer;
+	glGenBuffers(1, &new_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * element_size, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+	                    old_capacity * element_size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+	buffer = new_buffer;
+	// The vertex array still points at the old buffer
+	SetupVertexArray();
+
+	allocator.Grow(new_capacity);
+	if (!allocator.Allocate(size, offset)) {
+		std::cerr << "ERROR: Mesh arena failed to allocate after growing!" << std::endl;
+	}
+	return offset;
+}
+
+void MeshArena::SetupVertexArray() {
+	glBindVertexArray(vertexArrayID);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+	// Binding the element buffer while the vertex array is bound attaches it to the
+	//   vertex array
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferID);
+
+	/* ----- Set the attribute pointers for vertex data ----- */
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	if (vertexFormat == VertexFormat::PACKED) {
+		// The GPU unpacks each attribute to floats, so shaders read the same vec4 position,
+		//   vec3 normal & vec2 texCoord as with full vertices. Positions come out as [0, 1]
+		//   fractions of the model's bounds, with w = 1
+		glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+			(void*)offsetof(PackedVertex, position));
+		// Signed 10-bit xyz, plus 2 unused bits
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex),
+			(void*)offsetof(PackedVertex, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+			(void*)offsetof(PackedVertex, texCoord));
+	}
+	else {
+		// Position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// Normal attribute. Use the offsetof() macro for getting vertex offsets
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			(void*)offsetof(Vertex, normal));
+		// TexCoord attribute
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			(void*)offsetof(Vertex, texCoord));
+	}
+	// Per-instance attributes (modelview & normal matrices), from a separate buffer
+	RenderQueue::SetupInstanceAttributes(instanceBuffer);
+
+	// Unbind the vertex array BEFORE the element buffer, or the vertex array would
+	//   lose its element buffer
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+MeshArena::RangeAllocator::RangeAllocator(const GLuint capacity) :
+	capacity(capacity) {
+	if (capacity > 0) {
+		freeRanges[0] = capacity;
+	}
+}
+
+bool MeshArena::RangeAllocator::Allocate(const GLuint size, GLuint& offset) {
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+		if (it->second >= size) {
+			offset = it->first;
+			const GLuint remaining = it->second - size;
+			freeRanges.erase(it);
+			if (remaining > 0) {
+				freeRanges[offset + size] = remaining;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshArena::RangeAllocator::Free(const GLuint offset, const GLuint size) {
+	if (size == 0) {
+		return;
+	}
+	auto it = freeRanges.emplace(offset, size).first;
+	// Merge with the next range
+	auto next = std::next(it);
+	if (next != freeRanges.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		freeRanges.erase(next);
+	}
+	// Merge with the previous range
+	if (it != freeRanges.begin()) {
+		auto prev = std::prev(it);
+		if (prev->first + prev->second == it->first) {
+			prev->second += it->second;
+			freeRanges.erase(it);
+		}
+	}
+}
+
+void MeshArena::RangeAllocator::Grow(const GLuint new_capacity) {
+	const GLuint old_capacity = capacity;
+	capacity = new_capacity;
+	Free(old_capacity, new_capacity - old_capacity);
+}
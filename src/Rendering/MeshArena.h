@@ -0,0 +1,107 @@
+#pragma once
+
+#include <map>
+
+#include <glad/glad.h>
+
+// Layout of the vertices in a MeshArena. FULL uses Vertex, and PACKED uses the quantized
+//   PackedVertex (see StaticMesh.h). Every mesh in an arena uses the same format
+enum class VertexFormat { FULL, PACKED };
+
+///
+/// Layout of one command in a GL_DRAW_INDIRECT_BUFFER, as read by
+/// glMultiDrawElementsIndirect. Each command is an instanced draw of one mesh in the
+/// MeshArena
+///
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+///
+/// Shared vertex & index buffers that hold the geometry of every StaticMesh, with a single
+/// vertex array over them. Since all meshes use the same vertex array, any set of meshes
+/// can be drawn with one glMultiDrawElementsIndirect (as long as they share a shader and
+/// textures).
+///
+/// Each mesh gets a range of vertices and a range of indices. Indices stay relative to the
+/// mesh's first vertex, and draws add it back with baseVertex. The buffers grow (copying
+/// their contents on the GPU) when a mesh doesn't fit, and freed ranges are reused.
+///
+class MeshArena {
+public:
+	// Where a mesh's data is in the arena
+	struct Allocation {
+		GLuint firstVertex = 0;
+		GLuint numVertices = 0;
+		GLuint firstIndex = 0;
+		GLuint numIndices = 0;
+	};
+
+	// instance_buffer holds the per-instance attributes (see RenderQueue). Capacities are
+	//   only the starting sizes, since the buffers grow as needed
+	MeshArena(const VertexFormat vertex_format, const GLuint instance_buffer,
+	          const GLuint vertex_capacity = 1 << 16, const GLuint index_capacity = 1 << 18);
+	~MeshArena();
+	// Owns GL objects, so copying would double-delete them
+	MeshArena(const MeshArena&) = delete;
+	MeshArena& operator=(const MeshArena&) = delete;
+
+	// Copy a mesh into the arena. 'vertices' must be in the arena's vertex format. The data
+	//   is sent straight to the GPU, so it can come from anywhere (i.e. a memory-mapped file)
+	Allocation Allocate(const void* vertices, const GLuint num_vertices,
+	                    const GLuint* indices, const GLuint num_indices);
+	// Release a mesh's ranges, so later meshes can reuse them
+	void Free(const Allocation& allocation);
+
+	// Command that draws num_instances copies of a mesh, reading instance data from
+	//   base_instance onward
+	static DrawElementsIndirectCommand MakeDrawCommand(const Allocation& allocation,
+	                                                   const GLuint base_instance,
+	                                                   const GLuint num_instances);
+
+	// Size of one vertex in the given format
+	static size_t GetVertexSize(const VertexFormat format);
+
+	/* ----- Getters ----- */
+	GLuint GetVertexArrayID() const { return vertexArrayID; }
+	VertexFormat GetVertexFormat() const { return vertexFormat; }
+
+private:
+	///
+	/// First-fit allocator for ranges of elements in a buffer. Free ranges are merged
+	/// with their neighbors when they're released
+	///
+	class RangeAllocator {
+	public:
+		explicit RangeAllocator(const GLuint capacity);
+		// Find a free range of 'size' elements. Returns false if none is big enough
+		bool Allocate(const GLuint size, GLuint& offset);
+		void Free(const GLuint offset, const GLuint size);
+		// Add free space to the end, after the buffer grows
+		void Grow(const GLuint new_capacity);
+		GLuint GetCapacity() const { return capacity; }
+	private:
+		// Free ranges, as offset -> size
+		std::map<GLuint, GLuint> freeRanges;
+		GLuint capacity;
+	};
+
+	// Allocate 'size' elements from 'allocator', growing 'buffer' if they don't fit
+	GLuint AllocateRange(RangeAllocator& allocator, GLuint& buffer, const GLuint size,
+	                     const size_t element_size);
+	// Point the vertex array at the current vertex & index buffers
+	void SetupVertexArray();
+
+	const VertexFormat vertexFormat;
+	const size_t vertexSize;
+	const GLuint instanceBuffer;
+	GLuint vertexArrayID = 0;
+	GLuint vertexBufferID = 0;
+	GLuint elementBufferID = 0;
+	RangeAllocator vertexRanges;
+	RangeAllocator indexRanges;
+};
@@ -4,6 +4,7 @@
 
 #include "../AssetImport/Model.h"
 #include "../GameEngine.h"
+#include "RenderQueue.h"
 #include "ModelObject.h"
 #include "Scene.h"
 #include "ShaderProgram.h"
@@ -24,19 +25,37 @@ ModelObject::ModelObject(std::weak_ptr<GameEngine> engine, const std::string& na
 	//   if a model from this filepath hasn't been loaded before)
 	std::shared_ptr<Scene> scene_ref = engineRef.lock()->GetCurrentScene();
 	model = scene_ref->GetModel(path);
+	placeholderModel = scene_ref->GetPlaceholderModel();
 }
 
-void ModelObject::SetTextureOverride(std::weak_ptr<Texture> tex_override) {
+void ModelObject::SetTextureOverride(const std::shared_ptr<Texture>& tex_override) {
 	textureOverride = tex_override;
 }
 
+AABB ModelObject::GetWorldBounds(const glm::mat4& world_mtx) const {
+	if (std::shared_ptr<Model> drawn_model = GetDrawnModel()) {
+		return drawn_model->GetBounds().Transformed(AffineTransform(world_mtx));
+	}
+	return AABB();
+}
+
 void ModelObject::BeginPlay() {}
 
 void ModelObject::Render(const std::shared_ptr<ShaderProgram> shader) const {
-	// Call the parent's render function, which checks if the shader is bound and sends
-	//   the model/invT matrices
-	SceneObject::Render(shader);
+	// Queue this object in its model's batch. The Scene draws every batch at once after
+	//   all objects have been submitted
+	std::shared_ptr<Model> drawn_model = GetDrawnModel();
+	if (!drawn_model) {
+		return;
+	}
+	engineRef.lock()->GetRenderQueue().Submit(shader, drawn_model.get(), textureOverride,
+	                                          GetRenderTransformMtx());
+}
 
-	model.lock()->Render(shader, textureOverride);
+std::shared_ptr<Model> ModelObject::GetDrawnModel() const {
+	if (model && model->IsLoaded()) {
+		return model;
+	}
+	return placeholderModel.lock();
 }
 
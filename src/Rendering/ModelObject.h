@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "SceneObject.h"
+#include "../Utils/Bounds.h"
 class Model;
 class Scene;
 class Texture;
@@ -21,19 +22,30 @@ public:
 	~ModelObject() = default;
 
 	// Set the texture that will override the model's loaded textures when drawing
-	void SetTextureOverride(std::weak_ptr<Texture> tex_override);
+	void SetTextureOverride(const std::shared_ptr<Texture>& tex_override);
+
+	/* ----- Getters ----- */
+	// Box around the drawn model (see GetDrawnModel) in world space, with the given world
+	//   matrix
+	AABB GetWorldBounds(const glm::mat4& world_mtx) const;
 
 	// Inherited from SceneObject
 	virtual void BeginPlay() override;
 	virtual void Render(const std::shared_ptr<ShaderProgram> shader) const override;
 
 private:
+	// The model, or the scene's placeholder model while the model is still loading.
+	//   Returns null if neither is available
+	std::shared_ptr<Model> GetDrawnModel() const;
+
 	// Reference to a model that is managed by the scene. Multiple meshobjects can
-	//   reference the same model
-	std::weak_ptr<Model> model;
+	//   reference the same model, and the scene won't evict it while any of them exist
+	std::shared_ptr<Model> model;
+	// Drawn in the model's place until it has loaded
+	std::weak_ptr<Model> placeholderModel;
 
 	// Optional texture override - if null, just use the textures that are loaded
 	//   from the model's file
-	std::weak_ptr<Texture> textureOverride;
+	std::shared_ptr<Texture> textureOverride;
 };
 
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../AssetImport/Model.h"
+#include "../AssetImport/StaticMesh.h"
+#include "../AssetImport/Texture.h"
+#include "../Utils/AffineTransform.h"
+#include "RenderQueue.h"
+#include "ShaderProgram.h"
+
+RenderQueue::RenderQueue() :
+	viewMtx(1.0f) {
+	glGenBuffers(1, &instanceBufferID);
+	glGenBuffers(1, &commandBufferID);
+#ifdef GL_VERSION_4_3
+	useMultiDraw = GLAD_GL_VERSION_4_3;
+#endif
+	if (!useMultiDraw) {
+		std::cout << "WARNING: Multi-draw indirect is not supported, each mesh will be";
+		std::cout << " drawn with its own draw call instead" << std::endl;
+	}
+}
+
+RenderQueue::~RenderQueue() {
+	glDeleteBuffers(1, &instanceBufferID);
+	glDeleteBuffers(1, &commandBufferID);
+}
+
+void RenderQueue::SetupInstanceAttributes(const GLuint instance_buffer) {
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	// Matrix attributes take one location per column. A divisor of 1 moves to the next
+	//   InstanceData once per instance, instead of once per vertex
+	const GLuint mv_loc = FIRST_INSTANCE_ATTRIB;
+	for (GLuint i = 0; i < 4; ++i) {
+		glEnableVertexAttribArray(mv_loc + i);
+		glVertexAttribPointer(mv_loc + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(offsetof(InstanceData, Mv) + i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(mv_loc + i, 1);
+	}
+	const GLuint mv_invT_loc = FIRST_INSTANCE_ATTRIB + 4;
+	for (GLuint i = 0; i < 3; ++i) {
+		glEnableVertexAttribArray(mv_invT_loc + i);
+		glVertexAttribPointer(mv_invT_loc + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(offsetof(InstanceData, Mv_invT) + i * sizeof(glm::vec3)));
+		glVertexAttribDivisor(mv_invT_loc + i, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RenderQueue::BeginFrame(const glm::mat4& view_mtx, const Frustum& view_frustum) {
+	viewMtx = view_mtx;
+	frustum = view_frustum;
+	state.ResetStats();
+}
+
+void RenderQueue::Submit(const std::shared_ptr<ShaderProgram>& shader, const Model* model,
+                         const std::weak_ptr<Texture>& tex_override,
+                         const glm::mat4& world_mtx) {
+	/* ----- Frustum culling ----- */
+	// Try the sphere first since it's cheaper, then the tighter box. Models without bounds
+	//   have nothing to draw anyway
+	const AffineTransform world_transform(world_mtx);
+	if (!model->GetBounds().IsValid() ||
+	    !frustum.Intersects(model->GetBoundingSphere().Transformed(world_transform)) ||
+	    !frustum.Intersects(model->GetBounds().Transformed(world_transform))) {
+		state.RecordCulled();
+		return;
+	}
+
+	// Find this object's batch, or start a new one
+	const BatchKey key(shader.get(), model, tex_override.lock().get());
+	auto it = batchIndices.find(key);
+	if (it == batchIndices.end()) {
+		it = batchIndices.emplace(key, batches.size()).first;
+		batches.push_back(Batch{ shader, model, tex_override, {}, 0.0f });
+	}
+	Batch& batch = batches[it->second];
+
+	InstanceData instance;
+	const glm::mat4 model_view = viewMtx * world_mtx;
+	// Packed vertices are scaled back up to model space here, so the shaders don't need to
+	//   know the vertex format
+	instance.Mv = model_view * model->GetVertexTransform();
+	// Only the rotation & scale part is used for normals, since they have w = 0. Normals
+	//   aren't quantized against the bounds, so the vertex transform is left out
+	instance.Mv_invT = AffineTransform(model_view).GetNormalMatrix();
+	// The camera looks down -z, so depth is the negated eye-space z
+	const float depth = -model_view[3].z;
+	batch.minDepth = batch.instances.empty() ? depth : std::min(batch.minDepth, depth);
+	batch.instances.push_back(instance);
+}
+
+void RenderQueue::Flush() {
+	/* ----- Build a draw for each mesh of each batch ----- */
+	drawItems.clear();
+	GLuint num_instances = 0;
+	for (const Batch& batch : batches) {
+		if (batch.instances.empty()) {
+			continue;
+		}
+		for (const std::shared_ptr<StaticMesh>& mesh : batch.model->GetMeshes()) {
+			const uint64_t key = MakeSortKey(batch.shader->GetProgramID(),
+			                                 mesh->GetMaterialID(batch.texOverride),
+			                                 mesh->GetVertexArrayID(), batch.minDepth);
+			drawItems.push_back(DrawItem{ key, &batch, mesh.get(), num_instances });
+		}
+		num_instances += (GLuint)batch.instances.size();
+	}
+	if (drawItems.empty()) {
+		return;
+	}
+	std::sort(drawItems.begin(), drawItems.end(),
+		[](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+
+	/* ----- Upload every instance at once ----- */
+	// Re-specifying the whole buffer lets the driver hand out fresh storage if the GPU is
+	//   still reading last frame's instances, instead of stalling
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+	glBufferData(GL_ARRAY_BUFFER, num_instances * sizeof(InstanceData), nullptr,
+	             GL_STREAM_DRAW);
+	GLintptr offset = 0;
+	for (const Batch& batch : batches) {
+		const GLsizeiptr size = batch.instances.size() * sizeof(InstanceData);
+		if (size > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, offset, size, batch.instances.data());
+			offset += size;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	/* ----- Build the draw commands, and split them into runs that share state ----- */
+	commands.clear();
+	runs.clear();
+	for (size_t i = 0; i < drawItems.size(); ++i) {
+		const DrawItem& item = drawItems[i];
+		if (runs.empty() || !CanShareDraw(*runs.back().item, item)) {
+			runs.push_back(DrawRun{ &item, (GLuint)commands.size(), 0 });
+		}
+		++runs.back().numCommands;
+		commands.push_back(item.mesh->GetDrawCommand(item.baseInstance,
+		                                             (GLuint)item.batch->instances.size()));
+	}
+	if (useMultiDraw) {
+		// Stays bound while drawing, since glMultiDrawElementsIndirect reads from it
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBufferID);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER,
+		             commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(),
+		             GL_STREAM_DRAW);
+	}
+
+	/* ----- Draw in sorted order ----- */
+	// Other code (i.e. the skybox) binds objects directly, so the cached state can't be
+	//   trusted from one frame to the next
+	state.Invalidate();
+	for (const DrawRun& run : runs) {
+		const Batch& batch = *run.item->batch;
+		state.UseProgram(*batch.shader);
+		run.item->mesh->BindMaterial(state, *batch.shader, batch.texOverride);
+		state.BindVertexArray(run.item->mesh->GetVertexArrayID());
+		GLuint run_instances = 0;
+		for (GLsizei i = 0; i < run.numCommands; ++i) {
+			run_instances += commands[run.firstCommand + i].instanceCount;
+		}
+#ifdef GL_VERSION_4_3
+		if (useMultiDraw) {
+			// One call for the whole run. The offset points at the run's first command
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+				(void*)(run.firstCommand * sizeof(DrawElementsIndirectCommand)),
+				run.numCommands, 0);
+			// ^ 1: the primitive type
+			//   2: the type of the indices
+			//   3: byte offset of the first command in the command buffer
+			//   4: # of commands to draw
+			//   5: stride between commands, 0 = tightly packed
+			state.RecordDraw(run.numCommands, run_instances);
+			continue;
+		}
+#endif
+		for (GLsizei i = 0; i < run.numCommands; ++i) {
+			const DrawElementsIndirectCommand& command = commands[run.firstCommand + i];
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count,
+				GL_UNSIGNED_INT, (void*)(command.firstIndex * sizeof(GLuint)),
+				command.instanceCount, command.baseVertex, command.baseInstance);
+			state.RecordDraw(1, command.instanceCount);
+		}
+	}
+	if (useMultiDraw) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	state.Restore();
+
+	// Keep each batch's capacity for the next frame
+	for (Batch& batch : batches) {
+		batch.instances.clear();
+	}
+}
+
+void RenderQueue::ClearBatches() {
+	batches.clear();
+	batchIndices.clear();
+}
+
+bool RenderQueue::CanShareDraw(const DrawItem& a, const DrawItem& b) {
+	if (a.batch->shader != b.batch->shader ||
+	    a.mesh->GetVertexArrayID() != b.mesh->GetVertexArrayID()) {
+		return false;
+	}
+	// An override replaces the mesh's own textures, so only the override has to match
+	const std::shared_ptr<Texture> a_override = a.batch->texOverride.lock();
+	const std::shared_ptr<Texture> b_override = b.batch->texOverride.lock();
+	if (a_override || b_override) {
+		return a_override == b_override;
+	}
+	return a.mesh->SharesMaterial(*b.mesh);
+}
+
+uint64_t RenderQueue::MakeSortKey(const GLuint program, const GLuint material,
+                                  const GLuint vertex_array, const float depth) {
+	// The bits of a non-negative float sort in the same order as the float itself, so the
+	//   top 24 bits are a cheap way to quantize depth
+	const float clamped_depth = std::max(depth, 0.0f);
+	uint32_t depth_bits;
+	memcpy(&depth_bits, &clamped_depth, sizeof(depth_bits));
+	return ((uint64_t)(program & 0xFFF) << 52) |
+	       ((uint64_t)(material & 0xFFF) << 40) |
+	       ((uint64_t)(vertex_array & 0xFFFF) << 24) |
+	       (uint64_t)(depth_bits >> 8);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MeshArena.h"
+#include "RenderStateCache.h"
+#include "../Utils/Bounds.h"
+class Model;
+class ShaderProgram;
+class StaticMesh;
+class Texture;
+
+///
+/// Per-instance constants for a single ModelObject, read by the vertex shaders as
+/// instanced vertex attributes. Mv also applies the model's vertex transform (for packed
+/// vertices), and Mv_invT is the inverse transpose of the model-view matrix's rotation &
+/// scale, for transforming normals. The shaders find Mvp from P in the FrameData block
+///
+struct InstanceData {
+	glm::mat4 Mv;
+	glm::mat3 Mv_invT;
+};
+
+///
+/// Collects everything that's drawn in a frame, then draws it in an order that minimizes
+/// state changes.
+///
+/// ModelObjects that share a shader, Model, and texture override are grouped into one batch,
+/// and each mesh of a batch becomes a single instanced draw command. This keeps the command
+/// count of scenes with many identical objects (i.e. leg links) constant as objects are
+/// added.
+///
+/// Commands are sorted by a key built from (shader, material, vertex array, depth), so
+/// consecutive commands mostly share their bindings. Every mesh is stored in the MeshArena,
+/// so a run of commands with the same shader and textures is sent with a single
+/// glMultiDrawElementsIndirect. Binds go through a RenderStateCache, which skips the ones
+/// that are already current.
+///
+/// The MeshArena's vertex array reads its per-instance attributes from this queue's
+/// instance buffer (see SetupInstanceAttributes). All of a frame's instances are uploaded
+/// at once, and each command picks out its range with a base instance.
+///
+/// Objects outside the camera's frustum are dropped when they're submitted.
+///
+/// Usage: BeginFrame(), then Submit() every object, then Flush()
+///
+class RenderQueue {
+public:
+	// First vertex attribute location used by InstanceData. Mv takes 4 locations, and
+	//   Mv_invT takes the 3 after it. Keep in sync with the vertex shaders
+	static constexpr GLuint FIRST_INSTANCE_ATTRIB = 3;
+
+	RenderQueue();
+	~RenderQueue();
+	// Owns GL objects, so copying would double-delete them
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	// Point the instance attributes of the currently bound vertex array at the instance
+	//   buffer. Every vertex array that is drawn through the queue must call this
+	static void SetupInstanceAttributes(const GLuint instance_buffer);
+
+	// Start a new frame, using 'view_mtx' to find each instance's modelview matrix, and
+	//   'frustum' (in world space) to cull instances. Also resets the stats
+	void BeginFrame(const glm::mat4& view_mtx, const Frustum& frustum);
+	// Queue one instance of a model to be drawn with 'shader' on the next Flush, unless
+	//   its bounds are outside the frustum
+	void Submit(const std::shared_ptr<ShaderProgram>& shader, const Model* model,
+	            const std::weak_ptr<Texture>& tex_override, const glm::mat4& world_mtx);
+	// Sort and draw everything that was submitted. Leaves the last shader active, the
+	//   default vertex array bound, and texture unit 0 active
+	void Flush();
+	// Forget every batch, instead of keeping them for the next frame. Must be called when
+	//   models or textures are freed, since batches are keyed by their addresses
+	void ClearBatches();
+
+	/* ----- Getters ----- */
+	GLuint GetBufferID() const { return instanceBufferID; }
+	// Draw & bind counts so far in the current frame
+	const RenderStats& GetStats() const { return state.GetStats(); }
+
+private:
+	// Every instance of a model that shares the same shader and texture override
+	struct Batch {
+		std::shared_ptr<ShaderProgram> shader;
+		const Model* model;
+		std::weak_ptr<Texture> texOverride;
+		std::vector<InstanceData> instances;
+		// Smallest view-space depth of any instance, for front-to-back sorting
+		float minDepth;
+	};
+	typedef std::tuple<const ShaderProgram*, const Model*, const Texture*> BatchKey;
+
+	// A single mesh of a batch, and where its instances are in the instance buffer
+	struct DrawItem {
+		uint64_t sortKey;
+		const Batch* batch;
+		const StaticMesh* mesh;
+		GLuint baseInstance;
+	};
+	// Consecutive commands in the command buffer that are sent with one multi-draw call.
+	//   'item' is the first of them, which all of the others share their state with
+	struct DrawRun {
+		const DrawItem* item;
+		GLuint firstCommand;
+		GLsizei numCommands;
+	};
+
+	// Can 'b' be drawn with the same program, vertex array, and textures as 'a'?
+	static bool CanShareDraw(const DrawItem& a, const DrawItem& b);
+
+	// Pack the sorting criteria into a key, most expensive state change first:
+	//   [shader: 12 bits][material: 12][vertex array: 16][depth: 24]
+	//   IDs are truncated to fit, which only makes the grouping less perfect. Depth sorts
+	//   front to back, so nearby objects hide the ones behind them early
+	static uint64_t MakeSortKey(const GLuint program, const GLuint material,
+	                            const GLuint vertex_array, const float depth);
+
+	GLuint instanceBufferID = 0;
+	// Holds the draw commands for glMultiDrawElementsIndirect
+	GLuint commandBufferID = 0;
+	// Is glMultiDrawElementsIndirect supported? If not, each command is drawn separately
+	bool useMultiDraw = false;
+	glm::mat4 viewMtx;
+	Frustum frustum;
+	RenderStateCache state;
+	// Batches are kept between frames, so their instance lists don't have to be
+	//   reallocated. Empty batches are skipped when flushing
+	std::vector<Batch> batches;
+	std::map<BatchKey, size_t> batchIndices;
+	// Scratch space for Flush, kept to avoid reallocating every frame
+	std::vector<DrawItem> drawItems;
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<DrawRun> runs;
+};
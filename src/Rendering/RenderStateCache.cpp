@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "RenderStateCache.h"
+#include "ShaderProgram.h"
+
+RenderStateCache::RenderStateCache() {
+	GLint num_units = 0;
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &num_units);
+	textures.assign((size_t)num_units, UNKNOWN);
+}
+
+void RenderStateCache::Invalidate() {
+	vertexArray = UNKNOWN;
+	activeUnit = UNKNOWN;
+	std::fill(textures.begin(), textures.end(), UNKNOWN);
+}
+
+void RenderStateCache::Restore() {
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE0);
+	Invalidate();
+}
+
+void RenderStateCache::UseProgram(ShaderProgram& shader) {
+	// ShaderProgram already tracks the active program, so there's nothing to store here
+	if (shader.IsShaderActive()) {
+		++stats.numSkippedBinds;
+		return;
+	}
+	shader.Activate();
+	++stats.numProgramBinds;
+}
+
+void RenderStateCache::BindVertexArray(const GLuint vertex_array) {
+	if (vertexArray == vertex_array) {
+		++stats.numSkippedBinds;
+		return;
+	}
+	glBindVertexArray(vertex_array);
+	vertexArray = vertex_array;
+	++stats.numVertexArrayBinds;
+}
+
+void RenderStateCache::BindTexture(const GLuint unit, const GLuint texture) {
+	if (unit < textures.size() && textures[unit] == texture) {
+		++stats.numSkippedBinds;
+		return;
+	}
+	if (activeUnit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		activeUnit = unit;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if (unit < textures.size()) {
+		textures[unit] = texture;
+	}
+	++stats.numTextureBinds;
+}
+
+void RenderStateCache::RecordDraw(const size_t num_commands, const size_t num_instances) {
+	++stats.numDrawCalls;
+	stats.numDrawCommands += num_commands;
+	stats.numInstances += num_instances;
+}
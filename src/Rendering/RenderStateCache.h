@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+class ShaderProgram;
+
+///
+/// Number of GL calls made by the renderer in one frame. A single multi-draw call can hold
+/// several draw commands (one per mesh). Skipped binds are binds that were requested, but
+/// not sent to the driver since the object was already bound. Culled objects were
+/// submitted, but never reached the GPU
+///
+struct RenderStats {
+	size_t numDrawCalls = 0;
+	size_t numDrawCommands = 0;
+	size_t numInstances = 0;
+	size_t numCulled = 0;
+	size_t numProgramBinds = 0;
+	size_t numVertexArrayBinds = 0;
+	size_t numTextureBinds = 0;
+	size_t numSkippedBinds = 0;
+};
+
+///
+/// Remembers which program, vertex array, and textures are bound, and skips binds that
+/// wouldn't change anything. Only valid while every bind goes through the cache, so call
+/// Invalidate() whenever other code may have bound something (i.e. before each frame)
+///
+class RenderStateCache {
+public:
+	RenderStateCache();
+	~RenderStateCache() = default;
+
+	// Forget the current bindings, so the next bind of each kind always reaches the driver
+	void Invalidate();
+	// Bind the default vertex array and texture unit 0, like drawing code expects
+	//   elsewhere. Leaves the cache invalidated
+	void Restore();
+
+	void UseProgram(ShaderProgram& shader);
+	void BindVertexArray(const GLuint vertex_array);
+	void BindTexture(const GLuint unit, const GLuint texture);
+	// Count a draw call, which drew num_commands meshes, in the stats
+	void RecordDraw(const size_t num_commands, const size_t num_instances);
+	// Count an object that was culled before it was drawn
+	void RecordCulled() { ++stats.numCulled; }
+
+	/* ----- Getters ----- */
+	const RenderStats& GetStats() const { return stats; }
+
+	/* ----- Setters ----- */
+	void ResetStats() { stats = RenderStats(); }
+
+private:
+	// Value for bindings that aren't known, since 0 is a valid binding
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	GLuint vertexArray = UNKNOWN;
+	GLuint activeUnit = UNKNOWN;
+	// Texture bound to GL_TEXTURE_2D on each texture unit
+	std::vector<GLuint> textures;
+	RenderStats stats;
+};
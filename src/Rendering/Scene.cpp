@@ -7,6 +7,7 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include "../AssetImport/AssetLoader.h"
 #include "../AssetImport/Model.h"
 #include "../AssetImport/Texture.h"
 #include "../GameEngine.h"
@@ -14,29 +15,46 @@
 #include "../IK/LegTarget.h"
 #include "../Player/Camera.h"
 #include "../Player/SpiderCharacter.h"
+#include "../Utils/JobSystem.h"
+#include "../Utils/TransformSystem.h"
 #include "../Utils/YAMLHelper.h"
 #include "ModelObject.h"
+#include "RenderQueue.h"
 #include "Scene.h"
 #include "SceneObject.h"
 #include "ShaderProgram.h"
 #include "Skybox.h"
+#include "UniformBlocks.h"
+#include "UniformRingBuffer.h"
 #include "Window.h"
 
 Scene::Scene(std::weak_ptr<GameEngine> engine) :
-	engineRef(engine) {}
+	engineRef(engine),
+	modelCache(engine.lock()->GetModelCacheBudget()),
+	textureCache(engine.lock()->GetTextureCacheBudget()) {}
 
 void Scene::UpdateScenePhysics(const float delta_time) {
-	for (auto& object_ref : rootObjects) {
-		if (!object_ref.expired()) {
-			object_ref.lock()->PhysicsUpdate(delta_time);
-		}
-		else {
-			// Eventually, the rootObjects list should updated whenever SceneObjects are
-			//   removed from the scene. For now, just print an error message
-			std::cerr << "ERROR: null reference to a SceneObject in rootObjects list";
-			std::cerr << "while updating scene physics!" << std::endl;
-		}
+	std::shared_ptr<GameEngine> engine = engineRef.lock();
+	const std::shared_ptr<TransformSystem>& transform_system = engine->GetTransformSystem();
+	if (physicsOrder.size() != rootObjects.size() ||
+		physicsOrderVersion != transform_system->GetHierarchyVersion()) {
+		RebuildPhysicsOrder();
 	}
+
+	// Each root object's subtree is updated as its own job, so independent objects (i.e.
+	//   several spiders) update in parallel. Within a subtree, parents still update before
+	//   their children, and reading a parent's world transform brings it up to date
+	//   first, so it's always safe. Reading an object from a DIFFERENT subtree during
+	//   PhysicsUpdate is a data race, since that subtree may be updating at the same time
+	auto update_root = [this, delta_time](size_t root_idx) {
+		for (const std::shared_ptr<SceneObject>& object : physicsOrder[root_idx]) {
+			object->PhysicsUpdate(delta_time);
+		}
+	};
+	engine->GetJobSystem().ParallelFor(physicsOrder.size(), update_root);
+	// Then refresh every world matrix that's still stale in one linear pass, so rendering
+	//   only ever reads up-to-date matrices
+	transform_system->UpdateWorldMatrices();
 }
 
 void Scene::RenderScene(const unsigned int frame_delay_ms) const {
@@ -45,21 +63,32 @@ void Scene::RenderScene(const unsigned int frame_delay_ms) const {
 		std::cerr << "ERROR: No camera set in the game instance!" << std::endl;
 		return;
 	}
+	/* ----- Upload the per-frame constants ----- */
+	// Every shader reads these from the same uniform block, so they're only sent once
+	FrameUniforms frame_uniforms;
+	frame_uniforms.P = main_camera->GetProjectionMtx();
+	frame_uniforms.V = main_camera->GetViewMtx();
+	frame_uniforms.time = (float)glfwGetTime();
+	std::shared_ptr<GameEngine> engine = engineRef.lock();
+	engine->GetUniformBuffer().Push((GLuint)UniformBlockBinding::FRAME, frame_uniforms);
+
 	/* ----- Draw every SceneObject ----- */
+	// Every object submits its models to the render queue along with its shader, then the
+	//   queue sorts and draws everything at once. The queue culls each object against the
+	//   camera's frustum as it's submitted
+	const Frustum frustum(frame_uniforms.P * frame_uniforms.V);
+	RenderQueue& render_queue = engine->GetRenderQueue();
+	render_queue.BeginFrame(frame_uniforms.V, frustum);
 	for (const ShaderToObjectList& shader_to_object : allObjects) {
-		// Iterate through every shader, and draw the objects associated with it
-		std::shared_ptr<ShaderProgram> shader = shader_to_object.first;
-		shader->Activate();
-		// Try to set uniform variables in the shader, ignore them if they don't exist
-		shader->SetMat4Uniform("P", main_camera->GetProjectionMtx());
-		float time = glfwGetTime();
-		shader->SetFloatUniform("time", time);
-
-		// Render every object associated with this shader
 		for (const std::shared_ptr<SceneObject>& object : shader_to_object.second) {
 			object->Render(shader_to_object.first);
 		}
 	}
+	// Static models skip whole groups of off-screen objects through the BVH
+	staticBVH.Query(frustum, [this](const uint32_t idx) {
+		staticModels[idx].second->Render(staticModels[idx].first);
+	});
+	render_queue.Flush();
 
 	/* ----- Draw the skybox ----- */
 	// Send camera matrices to the shader
@@ -85,6 +114,16 @@ void Scene::LoadSceneFile(const std::string& filename) {
 	// Load the scene file
 	YAML::Node full_scene = YAML::LoadFile(filename);
 
+	/* ----- Load the placeholder model ----- */
+	// Every other model loads in the background, so this has to be ready before any
+	//   ModelObjects are created
+	std::shared_ptr<GameEngine> engine = engineRef.lock();
+	const std::string placeholder_path = engine->GetDefaultModelPath();
+	placeholderModel = std::make_shared<Model>(placeholder_path, shared_from_this(),
+	                                           engine->GetMeshArena());
+	modelCache.Insert(HashAssetPath(placeholder_path), placeholder_path, placeholderModel,
+	                  true);
+
 	/* ----- Load Shaders ----- */
 	assert(YAMLHelper::DoesMapHaveSequence(full_scene, "shaders"));
 	// Get the sequence of shaders (YAML::Sequence is similar to a std::vector)
@@ -115,9 +154,16 @@ void Scene::LoadSceneFile(const std::string& filename) {
 	// Read every SceneObject from the sequence
 	for (size_t i = 0; i < objects.size(); ++i) {
 		std::shared_ptr<SceneObject> new_object;
+		// Set if the object is a model that never moves
+		std::shared_ptr<ModelObject> static_model;
 		std::string object_type = YAMLHelper::GetMapVal<std::string>(objects[i], "type");
 		if (object_type == "model") {
-			new_object = LoadModel(objects[i]);
+			std::shared_ptr<ModelObject> new_model = LoadModel(objects[i]);
+			if (YAMLHelper::DoesMapHaveField(objects[i], "static") &&
+			    YAMLHelper::GetMapVal<bool>(objects[i], "static")) {
+				static_model = new_model;
+			}
+			new_object = new_model;
 		}
 		else if (object_type == "camera") {
 			new_object = LoadCamera(objects[i], first_camera);
@@ -132,7 +178,7 @@ void Scene::LoadSceneFile(const std::string& filename) {
 			abort();
 		}
 		// Once the mesh-specific stuff is loaded, load the rest of the SceneObject properties
-		LoadSceneObject(objects[i], new_object, object_name_map);
+		LoadSceneObject(objects[i], new_object, object_name_map, static_model);
 	}
 
 	/* ----- Load the Skybox ----- */
@@ -165,32 +211,93 @@ void Scene::LoadSceneFile(const std::string& filename) {
 			object->BeginPlay();
 		}
 	}
+	for (const StaticModel& static_model : staticModels) {
+		static_model.second->BeginPlay();
+	}
 
 	/* ----- Propagate parent-child transforms through the object hierarchy ----- */
 	UpdateScenePhysics(engineRef.lock()->GetPhysicsTimeStep());
+
+	/* ----- Build the BVH over static models, now that they're in place ----- */
+	staticWorldMatrices.reserve(staticModels.size());
+	for (const StaticModel& static_model : staticModels) {
+		staticWorldMatrices.push_back(static_model.second->GetWorldTransformMtx());
+	}
+	RebuildStaticBVH();
+}
+
+void Scene::RebuildPhysicsOrder() {
+	physicsOrder.clear();
+	physicsOrder.reserve(rootObjects.size());
+	for (const std::weak_ptr<SceneObject>& root : rootObjects) {
+		physicsOrder.emplace_back();
+		if (std::shared_ptr<SceneObject> object = root.lock()) {
+			// Breadth-first, so every parent comes before its children
+			std::vector<std::shared_ptr<SceneObject> >& subtree = physicsOrder.back();
+			subtree.emplace_back(object);
+			for (size_t i = 0; i < subtree.size(); ++i) {
+				const std::vector<std::shared_ptr<SceneObject> >& children =
+					subtree[i]->GetChildObjects();
+				subtree.insert(subtree.end(), children.begin(), children.end());
+			}
+		}
+		else {
+			// Eventually, the rootObjects list should updated whenever SceneObjects are
+			//   removed from the scene. For now, just print an error message
+			std::cerr << "ERROR: null reference to a SceneObject in rootObjects list ";
+			std::cerr << "while updating scene physics!" << std::endl;
+		}
+	}
+	physicsOrderVersion = engineRef.lock()->GetTransformSystem()->GetHierarchyVersion();
+}
+
+void Scene::RebuildStaticBVH() {
+	std::vector<AABB> static_bounds;
+	static_bounds.reserve(staticModels.size());
+	for (size_t i = 0; i < staticModels.size(); ++i) {
+		static_bounds.push_back(staticModels[i].second->GetWorldBounds(staticWorldMatrices[i]));
+	}
+	staticBVH.Build(static_bounds);
+}
+
+void Scene::TrimAssetCaches() {
+	// Freeing a model releases its meshes' textures, so trim the models first to let the
+	//   textures go in the same frame
+	const size_t num_freed = modelCache.Trim() + textureCache.Trim();
+	if (num_freed > 0) {
+		// Batches are keyed by asset addresses, which new assets may now reuse
+		engineRef.lock()->GetRenderQueue().ClearBatches();
+	}
 }
 
 std::shared_ptr<Model> Scene::GetModel(const std::string& filename) {
-	if (modelMap.count(filename)) {
+	const AssetID id = HashAssetPath(filename);
+	if (std::shared_ptr<Model> cached_model = modelCache.Find(id, filename)) {
 		// If it's already been loaded, return it
-		return modelMap[filename];
-	}
-	else {
-		// If it hasn't been loaded, create a new model and return it
-		modelMap[filename] = std::make_shared<Model>(filename, shared_from_this());
-		return modelMap[filename];
+		return cached_model;
 	}
+	// If it hasn't been loaded, create an empty model and fill it in the background
+	std::shared_ptr<GameEngine> engine = engineRef.lock();
+	auto new_model = std::make_shared<Model>(engine->GetMeshArena());
+	engine->GetAssetLoader().LoadModel(new_model, filename, shared_from_this());
+	modelCache.Insert(id, filename, new_model);
+	return new_model;
 }
 
 std::shared_ptr<Texture> Scene::GetTexture(const std::string& filename,
 	Texture::TextureType tex_type, TextureOptions options) {
-	if (textureMap.count(filename)) {
-		return textureMap[filename];
-	}
-	else {
-		textureMap[filename] = std::make_shared<Texture>(filename, tex_type, options);
-		return textureMap[filename];
+	const AssetID id = HashAssetPath(filename);
+	if (std::shared_ptr<Texture> cached_texture = textureCache.Find(id, filename)) {
+		return cached_texture;
 	}
+	auto new_texture = std::make_shared<Texture>(tex_type, options);
+	engineRef.lock()->GetAssetLoader().LoadTexture(new_texture, filename);
+	textureCache.Insert(id, filename, new_texture);
+	return new_texture;
+}
+
+std::shared_ptr<Model> Scene::GetPlaceholderModel() const {
+	return placeholderModel;
 }
 
 inline std::shared_ptr<ModelObject> Scene::LoadModel(const YAML::Node& model_node) {
@@ -233,15 +340,31 @@ inline std::shared_ptr<SpiderCharacter> Scene::LoadSpider(const YAML::Node& spid
 	const bool show_targets = YAMLHelper::GetMapVal<bool>(spider_node, "show_leg_targets");
 	const float target_threshold = YAMLHelper::GetMapVal<float>(spider_node, "leg_target_threshold");
 	const float leg_move_time = YAMLHelper::GetMapVal<float>(spider_node, "leg_move_time");
+	// Optional IK settings. If they aren't in the file, keep the defaults
+	SpiderCharacter::IKSettings ik_settings;
+	if (YAMLHelper::DoesMapHaveField(spider_node, "batch_leg_ik")) {
+		ik_settings.batchLegIK = YAMLHelper::GetMapVal<bool>(spider_node, "batch_leg_ik");
+	}
+	if (YAMLHelper::DoesMapHaveField(spider_node, "ik_solver")) {
+		ik_settings.method = ChainSolver::ParseMethod(
+			YAMLHelper::GetMapVal<std::string>(spider_node, "ik_solver"));
+	}
+	if (YAMLHelper::DoesMapHaveField(spider_node, "show_ik_stats")) {
+		ik_settings.showIKStats = YAMLHelper::GetMapVal<bool>(spider_node, "show_ik_stats");
+	}
+	if (YAMLHelper::DoesMapHaveField(spider_node, "ik_target_epsilon")) {
+		ik_settings.targetEpsilon = YAMLHelper::GetMapVal<double>(spider_node, "ik_target_epsilon");
+	}
 	auto new_spider = std::make_shared<SpiderCharacter>(engineRef, spider_name,
 		move_speed, turn_speed, legs_per_side, links_per_chain, leg_loc, target_loc,
-		show_legs, show_targets, target_threshold, leg_move_time);
+		show_legs, show_targets, target_threshold, leg_move_time, ik_settings);
 	return new_spider;
 }
 
 void Scene::LoadSceneObject(const YAML::Node& object_node,
                             const std::shared_ptr<SceneObject>& new_object,
-                            std::unordered_map<std::string, std::shared_ptr<SceneObject>>& object_name_map) {
+                            std::unordered_map<std::string, std::shared_ptr<SceneObject>>& object_name_map,
+                            const std::shared_ptr<ModelObject>& static_model) {
 	// Load the transform as a single map object
 	new_object->SetRelativeTransform(YAMLHelper::GetMapVal<Transform>(object_node,
 		                            "relative_transform"));
@@ -273,7 +396,13 @@ void Scene::LoadSceneObject(const YAML::Node& object_node,
 	std::string shader_name = YAMLHelper::GetMapVal<std::string>(object_node, "shader");
 	// Add the object to the shader's list
 	if (shaderMap.count(shader_name) > 0) {
-		allObjects.at(shaderMap[shader_name]).second.push_back(new_object);
+		ShaderToObjectList& shader_list = allObjects.at(shaderMap[shader_name]);
+		if (static_model) {
+			staticModels.emplace_back(shader_list.first, static_model);
+		}
+		else {
+			shader_list.second.push_back(new_object);
+		}
 	}
 	else {
 		std::cerr << "ERROR: Drawing object in scene, but no shader with name ";
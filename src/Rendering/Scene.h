@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -7,7 +8,9 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include "../AssetImport/AssetCache.h"
 #include "../AssetImport/Texture.h"
+#include "../Utils/BVH.h"
 class Camera;
 class GameEngine;
 class IKChain;
@@ -27,20 +30,32 @@ public:
 	Scene(std::weak_ptr<GameEngine> engine);
 	~Scene() = default;
 
-	// Iterate through the scene hierarchy, updating each object's modelview matrices
+	// Iterate through the scene hierarchy, updating each object's modelview matrices.
+	//   Independent root objects are updated in parallel
 	void UpdateScenePhysics(const float delta_time);
-	// Iterate over each shader, rendering the objects that are drawn by it
+	// Submit every object to the render queue with its shader, then draw them all
 	void RenderScene(const unsigned int frameDelayMs) const;
 	// Instantiate every shader & SceneObject that will be used in this game
 	void LoadSceneFile(const std::string& filename);
+	// Flatten the hierarchy under each root object into physicsOrder
+	void RebuildPhysicsOrder();
+	// Rebuild the static models' BVH. Call after models finish loading, since a model's
+	//   bounds change when it replaces the placeholder
+	void RebuildStaticBVH();
+	// Free cached models & textures that nothing uses, if the caches are over budget.
+	//   Called once per frame
+	void TrimAssetCaches();
 	// Get a reference to the Model with the provided path, or 
-	//   create a new one if it hasn't been loaded yet
+	//   create a new one if it hasn't been loaded yet. New models are loaded in the
+	//   background, and are empty until they're ready
 	std::shared_ptr<Model> GetModel(const std::string& filename);
 	// Get/Create a Texture with the provided path. If creating a new texture,
-	//   set its texture type with tex_type
+	//   set its texture type with tex_type. New textures are also loaded in the background
 	std::shared_ptr<Texture> GetTexture(const std::string& filename,
 		Texture::TextureType tex_type = Texture::TextureType::DIFFUSE,
 		TextureOptions options = TextureOptions());
+	// Model that's drawn in place of models that are still loading
+	std::shared_ptr<Model> GetPlaceholderModel() const;
 
 private:
 	/* ----- Functions for loading subclasses of SceneObjects ----- */
@@ -50,9 +65,11 @@ private:
 	inline std::shared_ptr<SpiderCharacter> LoadSpider(const YAML::Node& spider_node);
 	// Loads parameters that ALL sceneobjects contain (i.e. transform, shader, etc.), then 
 	//   handles object parenting and adds the object to the scene
+	//   Static models are kept out of allObjects, and drawn through staticBVH instead
 	void LoadSceneObject(const YAML::Node& object_node,
 	                     const std::shared_ptr<SceneObject>& new_object,
-	                     std::unordered_map<std::string, std::shared_ptr<SceneObject>>& object_name_map);
+	                     std::unordered_map<std::string, std::shared_ptr<SceneObject>>& object_name_map,
+	                     const std::shared_ptr<ModelObject>& static_model = nullptr);
 
 	// Weak reference to the GameEngine that manages this scene
 	std::weak_ptr<GameEngine> engineRef;
@@ -69,22 +86,39 @@ private:
 	// List of every shader, and the objects that are drawn by them
 	std::vector<ShaderToObjectList> allObjects;
 
+	// Models that are marked static in the scene file, and the shaders they're drawn with.
+	//   Their world bounds are stored in staticBVH when the scene is loaded, so static
+	//   objects must never move afterward
+	typedef std::pair<std::shared_ptr<ShaderProgram>, std::shared_ptr<ModelObject> > StaticModel;
+	std::vector<StaticModel> staticModels;
+	// World matrix of each static model, stored once the scene is loaded. The BVH is
+	//   rebuilt from these, so it never reads transforms that physics may be writing
+	std::vector<glm::mat4> staticWorldMatrices;
+	BVH staticBVH;
+
 	// List of every root object in the scene (for calling physics updates)
 	// Root objects are SceneObjects that are parented to the world origin
 	std::vector<std::weak_ptr<SceneObject> > rootObjects;
+	// Every object under each root object, parents before children, in the order that
+	//   their physics is updated. Flattened so that a physics update doesn't have to walk
+	//   the hierarchy. Rebuilt whenever the TransformSystem's hierarchy version changes
+	std::vector<std::vector<std::shared_ptr<SceneObject> > > physicsOrder;
+	uint32_t physicsOrderVersion = 0;
 
 	// List of every physics object in the scene (for raycasting)
 	// TODO
 
-	// Mapping from filepaths to models. All ModelObjects store references
-	//   to this master list
-	std::unordered_map<std::string, std::shared_ptr<Model> > modelMap;
-	// ^ Note: If I stored these as weak_ptrs, they would automatically deallocate
-	//   themselves if no ModelObjects are referencing them
+	// Every loaded model, by path. ModelObjects hold references to their models, and
+	//   models that no ModelObject uses are freed once the cache goes over budget
+	AssetCache<Model> modelCache;
+	// The engine's default model, loaded right away so it can stand in for other models.
+	//   Pinned in the cache, so it's never freed
+	std::shared_ptr<Model> placeholderModel;
 
-	// Mapping from filepaths to textures. All StaticMeshes store references
-	//   to this master list
-	std::unordered_map<std::string, std::shared_ptr<Texture> > textureMap;
+	// Every loaded texture, by path. StaticMeshes (and ModelObjects with a texture
+	//   override) hold references to their textures, so a texture can only be freed
+	//   after every model that uses it
+	AssetCache<Texture> textureCache;
 
 	// List of every texture in the scene, excluding skybox textures
 
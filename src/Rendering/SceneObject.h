@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 
 #include "../Utils/Transform.h"
+#include "../Utils/TransformSystem.h"
 class GameEngine;
 class ShaderProgram;
 
@@ -15,48 +16,80 @@ class ShaderProgram;
 class SceneObject : public std::enable_shared_from_this<SceneObject> {
 public:
 	SceneObject(std::weak_ptr<GameEngine> engine, const std::string& name);
-	~SceneObject() = default;
+	// Each object owns a node in the engine's TransformSystem, so objects can't be copied
+	SceneObject(const SceneObject&) = delete;
+	SceneObject& operator=(const SceneObject&) = delete;
+	virtual ~SceneObject();
 
 	// Runs after all objects are loaded, before the first frame is drawn
 	virtual void BeginPlay();
-	// Find this object's (world) model mtx and iterate recursively to update child matrices
+	// Run this object's per-tick logic, and ONLY this object's. The Scene calls this on
+	//   every object in its hierarchy, parents before children. World matrices are not
+	//   computed here: the Scene updates every one of them in a single pass afterward
 	virtual void PhysicsUpdate(const float delta_time);
-	// Draw this object, and ONLY this object. Do not draw children
+	// Submit this object, and ONLY this object, to the engine's RenderQueue to be drawn
+	//   with 'shader'. Do not draw children. Nothing is drawn until the queue is flushed,
+	//   so the shader doesn't need to be active
 	virtual void Render(const std::shared_ptr<ShaderProgram> shader) const;
 
 	/* ----- Getters ----- */
+	// Note: brings the matrix up to date first if this object (or a parent) has moved
+	//   since the last world matrix update
 	const glm::mat4& GetWorldTransformMtx() const;
+	// World matrix in the frame being drawn, blended between the last two physics steps.
+	//   Use this instead of GetWorldTransformMtx when rendering, since physics may be
+	//   running on another thread
+	const glm::mat4& GetRenderTransformMtx() const;
+	const Transform& GetRelativeTransform() const;
 	const glm::vec3& GetRelativeLocation() const;
 	const glm::quat& GetRelativeRotation() const;
 	const glm::vec3& GetRelativeScale() const;
 	const std::string& GetName() const;
 	const std::weak_ptr<SceneObject>& GetParent() const;
+	const std::vector<std::shared_ptr<SceneObject> >& GetChildObjects() const;
+	TransformSystem::Handle GetTransformHandle() const;
 	// Search for a child with a given name from among the DIRECT children of this object
 	std::weak_ptr<SceneObject> GetChildByName(const std::string& name);
 
 	/* ----- Setters ----- */
-	void AddChildObject(std::weak_ptr<SceneObject> new_object);
+	void AddChildObject(const std::shared_ptr<SceneObject>& new_object);
 	void SetParent(std::weak_ptr<SceneObject> new_parent);
 	void SetRelativeLocation(const glm::vec3 loc);
 	void SetRelativeRotation(const glm::quat rot);
 	void SetRelativeRotationDegrees(const glm::vec3 euler_rot);
 	void SetRelativeScale(const glm::vec3 scale);
 	void SetRelativeTransform(const Transform& transform);
+	// Flag this object as changed. Only touches this object, so it's O(1): children find
+	//   out that their parent moved through the TransformSystem's world versions instead
 	void MarkPhysicsDirty();
 
 protected:
-	// Does this object need to update its model matrix on the next physics tick?
+	// Mutable access to the transform relative to this object's parent. Note: the caller
+	//   is responsible for calling MarkPhysicsDirty afterward
+	Transform& GetMutableRelativeTransform();
+	// Set this object's world matrix directly, ignoring its parent and relative transform
+	//   from then on. Children still follow this object as usual
+	void SetWorldTransformMtx(const glm::mat4& world_mtx);
+	// Has this object been marked dirty, or has its parent (or any further ancestor) moved,
+	//   since the last call to ClearPhysicsDirty?
+	bool IsPhysicsDirty() const;
+	void ClearPhysicsDirty();
+
+	// Was this object itself marked dirty since the last call to ClearPhysicsDirty?
 	bool physicsDirty = true;
+	// World version of the parent when ClearPhysicsDirty was last called
+	uint32_t seenParentVersion = 0;
 	// Name of this object, for debugging and parenting on construction
 	const std::string objectName = "unnamed_object";
 	// Reference to the gameengine that created this object
 	std::weak_ptr<GameEngine> engineRef;
-	// Transform relative to this object's parent
-	Transform rootTransform;
-	// Model matrix for this object (i.e. object-to-WORLD) transformation
-	glm::mat4 modelMtx = glm::mat4(1.0f);
-	// List of other SceneObjects that are attached to this object
-	std::vector<std::weak_ptr<SceneObject> > childObjects;
+	// Storage for this object's relative transform and model (i.e. object-to-WORLD)
+	//   matrix. Kept alive by every object, so nodes can be released in any order
+	std::shared_ptr<TransformSystem> transformSystem;
+	TransformSystem::Handle transformHandle = TransformSystem::INVALID_HANDLE;
+	// List of other SceneObjects that are attached to this object. Parents keep their
+	//   children alive, so walking the hierarchy never has to lock a weak_ptr
+	std::vector<std::shared_ptr<SceneObject> > childObjects;
 	// Object that this object is attached to
 	std::weak_ptr<SceneObject> parent;
 };
@@ -1,16 +1,33 @@
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include "ShaderProgram.h"
+#include "UniformBlocks.h"
+
+GLuint ShaderProgram::activeProgram = 0;
+
+uint32_t ShaderProgram::HashName(const char* name) {
+	uint32_t hash = 2166136261u;
+	for (const char* c = name; *c != '\0'; ++c) {
+		hash ^= (uint8_t)*c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
 
 ShaderProgram::ShaderProgram(const std::string& name) :
 	shaderName(name)
 {}
 
 ShaderProgram::~ShaderProgram() {
+	if (activeProgram == programID) {
+		activeProgram = 0;
+	}
 	// Completely deallocate this shader
 	glDeleteProgram(programID);
 }
@@ -77,69 +94,125 @@ void ShaderProgram::Compile(const std::string& vert_path, const std::string& fra
 	// Since the shaders are now linked to the program, we don't need them anymore
 	glDeleteShader(vert_shader);
 	glDeleteShader(frag_shader);
+
+	/* ----- Connect the shared uniform block to its binding point ----- */
+	// Note: GLSL 330 can't set block bindings in the shader itself, so they're set here.
+	//   Shaders that don't use a block just skip it
+	GLuint frame_block = glGetUniformBlockIndex(programID, "FrameData");
+	if (frame_block != GL_INVALID_INDEX) {
+		glUniformBlockBinding(programID, frame_block, (GLuint)UniformBlockBinding::FRAME);
+	}
+
+	ReflectUniforms();
 }
 
 void ShaderProgram::Activate() {
 	glUseProgram(programID);
+	activeProgram = programID;
 }
 
 void ShaderProgram::Deactivate() {
 	glUseProgram(0);
+	activeProgram = 0;
 }
 
-GLint ShaderProgram::GetUniform(const std::string& name, bool verbose) const {
-	// Check that this shader is active in the opengl context
-	GLint current_program;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
-	if (programID != (GLuint)current_program) {
-		std::cerr << "ERROR: Attempted to get a uniform from a non-activated shader!";
-		std::cerr << std::endl;
-		return -1;
-	}
-
-	// Check that the uniform's name exists on the shader
-	GLint location = glGetUniformLocation(programID, name.c_str());
-	if (location < 0) {
-		if (verbose) {
-			std::cerr << "ERROR: Uniform \"" << name << "\" does not exist in shader!";
-			std::cerr << std::endl;
+ShaderProgram::UniformHandle ShaderProgram::GetUniform(const char* name, bool verbose) const {
+	UniformHandle handle;
+	// Compare the full name too, in case two names have the same hash. There's almost
+	//   always just the one entry
+	auto range = uniforms.equal_range(HashName(name));
+	for (auto it = range.first; it != range.second; ++it) {
+		if (strcmp(it->second.name.c_str(), name) == 0) {
+			handle.location = it->second.location;
+			break;
 		}
-		return -1;
 	}
-
-	return location;
+	if (!handle.IsValid() && verbose) {
+		std::cerr << "ERROR: Uniform \"" << name << "\" does not exist in shader!";
+		std::cerr << std::endl;
+	}
+	return handle;
 }
 
 bool ShaderProgram::IsShaderActive() const {
-	GLint current_program;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
-	return (current_program == programID);
+	return activeProgram == programID;
 }
 
 const std::string ShaderProgram::GetShaderName() const {
 	return shaderName;
 }
 
-void ShaderProgram::SetIntUniform(const std::string& name, const GLint value,
-                                  bool verbose) {
-	GLint location = GetUniform(name, verbose);
-	if (location != -1) {
-		glUniform1i(location, value);
+GLuint ShaderProgram::GetProgramID() const {
+	return programID;
+}
+
+size_t ShaderProgram::GetNumUniforms() const {
+	return uniforms.size();
+}
+
+void ShaderProgram::SetIntUniform(const char* name, const GLint value, bool verbose) {
+	SetIntUniform(GetUniform(name, verbose), value);
+}
+
+void ShaderProgram::SetFloatUniform(const char* name, const GLfloat value, bool verbose) {
+	SetFloatUniform(GetUniform(name, verbose), value);
+}
+
+void ShaderProgram::SetMat4Uniform(const char* name, const glm::mat4& matrix, bool verbose) {
+	SetMat4Uniform(GetUniform(name, verbose), matrix);
+}
+
+void ShaderProgram::SetIntUniform(const UniformHandle uniform, const GLint value) {
+	if (uniform.IsValid() && CheckActive()) {
+		glUniform1i(uniform.location, value);
+	}
+}
+
+void ShaderProgram::SetFloatUniform(const UniformHandle uniform, const GLfloat value) {
+	if (uniform.IsValid() && CheckActive()) {
+		glUniform1f(uniform.location, value);
+	}
+}
+
+void ShaderProgram::SetMat4Uniform(const UniformHandle uniform, const glm::mat4& matrix) {
+	if (uniform.IsValid() && CheckActive()) {
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 }
 
-void ShaderProgram::SetFloatUniform(const std::string& name, const GLfloat value,
-                                    bool verbose) {
-	GLint location = GetUniform(name, verbose);
-	if (location != -1) {
-		glUniform1f(location, value);
+void ShaderProgram::ReflectUniforms() {
+	uniforms.clear();
+	GLint num_uniforms = 0;
+	GLint max_name_length = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &num_uniforms);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+	std::vector<GLchar> name_buffer(max_name_length + 1, '\0');
+	for (GLint i = 0; i < num_uniforms; ++i) {
+		GLsizei name_length = 0;
+		GLint array_size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(programID, (GLuint)i, (GLsizei)name_buffer.size(), &name_length,
+		                   &array_size, &type, name_buffer.data());
+		std::string name(name_buffer.data(), name_length);
+		// Arrays are reported as "name[0]", but are set through their base name
+		const size_t bracket = name.find('[');
+		if (bracket != std::string::npos) {
+			name.resize(bracket);
+		}
+		// Uniforms inside blocks have no location, and are set through the block instead
+		const GLint location = glGetUniformLocation(programID, name.c_str());
+		if (location < 0) {
+			continue;
+		}
+		uniforms.emplace(HashName(name.c_str()), UniformInfo{ name, location });
 	}
 }
 
-void ShaderProgram::SetMat4Uniform(const std::string& name, const glm::mat4& matrix,
-                                   bool verbose) {
-	GLint location = GetUniform(name, verbose);
-	if (location != -1) {
-		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+bool ShaderProgram::CheckActive() const {
+	if (activeProgram != programID) {
+		std::cerr << "ERROR: Attempted to set a uniform on a non-activated shader!";
+		std::cerr << std::endl;
+		return false;
 	}
+	return true;
 }
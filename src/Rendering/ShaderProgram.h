@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -8,9 +10,25 @@
 /// 
 /// Base class for all shaders, manages the compilation & 
 /// lifetime of a shader program
+///
+/// Every active uniform is looked up once after linking and stored in a hash map keyed by
+/// a hash of its name (along with the name itself, to tell apart names with the same hash),
+/// so setting a uniform never asks the driver for its location or allocates a string. The currently active program is tracked on the CPU side too, so it
+/// never has to be queried either. Note: this only works if every program is activated
+/// through a ShaderProgram, rather than calling glUseProgram directly
 /// 
 class ShaderProgram {
 public:
+	// Location of a uniform in a specific shader, from GetUniform. Keep handles around to
+	//   skip the name lookup entirely when the same uniform is set often
+	struct UniformHandle {
+		GLint location = -1;
+		bool IsValid() const { return location >= 0; }
+	};
+
+	// FNV-1a hash of a uniform's name, used as the key for the uniform table
+	static uint32_t HashName(const char* name);
+
 	ShaderProgram() = default;
 	ShaderProgram(const std::string& name);
 	~ShaderProgram();
@@ -24,18 +42,44 @@ public:
 	void Deactivate();
 
 	/* ----- Getters ----- */
-	// Return index of uniform if it exists, -1 if it doesn't
-	GLint GetUniform(const std::string& name, bool verbose = false) const;
+	// Return a handle to the uniform if it exists, or an invalid handle if it doesn't.
+	//   Note: uniforms inside uniform blocks don't have locations, so they're not included
+	UniformHandle GetUniform(const char* name, bool verbose = false) const;
 	bool IsShaderActive() const;
 	const std::string GetShaderName() const;
+	GLuint GetProgramID() const;
+	// Number of active uniforms found after linking (not counting uniform blocks)
+	size_t GetNumUniforms() const;
 
 	/* ----- Setters ----- */
-	void SetIntUniform(const std::string& name, const GLint value, bool verbose = false);
-	void SetFloatUniform(const std::string& name, const GLfloat value, bool verbose = false);
-	void SetMat4Uniform(const std::string& name, const glm::mat4& matrix, bool verbose = false);
+	// Set uniforms by name. Uniforms that don't exist are ignored (with an error if verbose)
+	void SetIntUniform(const char* name, const GLint value, bool verbose = false);
+	void SetFloatUniform(const char* name, const GLfloat value, bool verbose = false);
+	void SetMat4Uniform(const char* name, const glm::mat4& matrix, bool verbose = false);
+	// Set uniforms through a handle from GetUniform. Invalid handles are ignored
+	void SetIntUniform(const UniformHandle uniform, const GLint value);
+	void SetFloatUniform(const UniformHandle uniform, const GLfloat value);
+	void SetMat4Uniform(const UniformHandle uniform, const glm::mat4& matrix);
 
 private:
+	// Info about an active uniform, from glGetActiveUniform
+	struct UniformInfo {
+		std::string name;
+		GLint location;
+	};
+
+	// Fill in the uniform table from the linked program
+	void ReflectUniforms();
+	// Is this shader active? If not, print an error, since uniforms can only be set on the
+	//   active program
+	bool CheckActive() const;
+
 	const std::string shaderName = "unnamed_shader";
 	GLuint programID = 0;
+	// Every active uniform in the program, keyed by HashName(name). A multimap, so that
+	//   uniforms whose names have the same hash are all kept
+	std::unordered_multimap<uint32_t, UniformInfo> uniforms;
+	// Program that was most recently activated through any ShaderProgram
+	static GLuint activeProgram;
 };
 
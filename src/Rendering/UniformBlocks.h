@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// CPU-side layouts of the uniform blocks shared by every shader. Each struct matches the
+//   std140 layout of the GLSL block with the same name, so keep them in sync with the
+//   shader files. ShaderProgram binds each block to its binding point after linking.
+//   Per-object constants are instanced vertex attributes instead (see RenderQueue)
+
+// Binding points of the shared uniform blocks
+enum class UniformBlockBinding : GLuint {
+	FRAME = 0
+};
+
+///
+/// Constants that are the same for every object in a frame. Uploaded once per frame.
+/// GLSL name: FrameData
+///
+struct FrameUniforms {
+	glm::mat4 P;
+	glm::mat4 V;
+	float time;
+	// std140 rounds the block size up to a multiple of a vec4
+	float padding[3];
+};
+
+static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms must match the std140 layout");
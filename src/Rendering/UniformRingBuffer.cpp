@@ -0,0 +1,54 @@
+#include <iostream>
+
+#include "UniformRingBuffer.h"
+
+UniformRingBuffer::UniformRingBuffer(const size_t frame_size, const size_t num_frames) :
+	numFrames(num_frames)
+{
+	GLint alignment;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	offsetAlignment = (size_t)alignment;
+	// Every region has to start on an aligned offset too
+	frameSize = Align(frame_size);
+	const GLsizeiptr total_size = (GLsizeiptr)(frameSize * numFrames);
+
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+	glBufferData(GL_UNIFORM_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+	glDeleteBuffers(1, &bufferID);
+}
+
+void UniformRingBuffer::BeginFrame() {
+	frameIdx = (frameIdx + 1) % numFrames;
+	head = 0;
+	numPushes = 0;
+	reportedFull = false;
+}
+
+bool UniformRingBuffer::Push(const GLuint binding, const void* data, const size_t size) {
+	const size_t aligned_size = Align(size);
+	if (head + aligned_size > frameSize) {
+		if (!reportedFull) {
+			std::cerr << "ERROR: Uniform ring buffer is full, increase its frame size! ";
+			std::cerr << "Skipping blocks for the rest of this frame" << std::endl;
+			reportedFull = true;
+		}
+		return false;
+	}
+	const size_t offset = frameIdx * frameSize + head;
+	// Note: glBindBufferRange also binds the buffer to the generic GL_UNIFORM_BUFFER target,
+	//   which glBufferSubData writes through
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, bufferID, (GLintptr)offset, (GLsizeiptr)size);
+	glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+	head += aligned_size;
+	++numPushes;
+	return true;
+}
+
+size_t UniformRingBuffer::Align(const size_t size) const {
+	return (size + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+///
+/// Uniform buffer for the per-frame constant blocks, with one small region per frame in
+/// flight so that writing a frame's constants never waits on the GPU reading the last
+/// frame's. Each block that's pushed gets the next aligned slot in the current frame's
+/// region and is bound to its binding point with glBindBufferRange. Per-object constants
+/// don't go through here, since they're instance attributes (see RenderQueue).
+///
+/// Blocks are written with glBufferSubData. Persistent mapping would need GL 4.4, but the
+/// context only asks for 4.3, and one small block per frame isn't worth a second path.
+/// Cycling through the regions keeps each write away from the ranges that the GPU may still
+/// be reading, so the driver doesn't have to stall or copy the buffer.
+///
+/// Usage: BeginFrame(), then Push() each of the frame's blocks
+///
+class UniformRingBuffer {
+public:
+	// frame_size is the number of bytes available to each frame. It's rounded up to the
+	//   offset alignment, as is every pushed block, so one block only needs its own size
+	UniformRingBuffer(const size_t frame_size, const size_t num_frames = 3);
+	~UniformRingBuffer();
+	// Owns GL objects, so copying would double-delete them
+	UniformRingBuffer(const UniformRingBuffer&) = delete;
+	UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+	// Move to the next frame's region
+	void BeginFrame();
+
+	// Copy a block into the next slot of this frame's region and bind it to 'binding'.
+	//   Returns false (without binding anything) if the region is full
+	bool Push(const GLuint binding, const void* data, const size_t size);
+	template <typename T>
+	bool Push(const GLuint binding, const T& block) {
+		return Push(binding, &block, sizeof(T));
+	}
+
+	/* ----- Getters ----- */
+	// Number of blocks pushed so far in the current frame
+	size_t GetNumPushes() const { return numPushes; }
+
+private:
+	// Round 'size' up to the buffer offset alignment
+	size_t Align(const size_t size) const;
+
+	GLuint bufferID = 0;
+	// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, since every bound range must start on it
+	size_t offsetAlignment = 256;
+	// Size of each frame's region, rounded up to the offset alignment
+	size_t frameSize = 0;
+	const size_t numFrames;
+	// Index of the current frame's region, and the next free byte within it
+	size_t frameIdx = 0;
+	size_t head = 0;
+	size_t numPushes = 0;
+	// Has the "buffer full" error been printed this frame?
+	bool reportedFull = false;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+///
+/// Compact affine transform: a 3x3 linear part (rotation & scale) plus a translation, i.e.
+/// the top 3 rows of a 4x4 model matrix. Composing two of these skips the bottom row of
+/// a general mat4 multiply, which is always (0, 0, 0, 1) for scene transforms
+///
+class AffineTransform {
+public:
+	AffineTransform() :
+		linear(1.0f),
+		translation(0.0f, 0.0f, 0.0f) {}
+	AffineTransform(const glm::mat3& in_linear, const glm::vec3& in_translation) :
+		linear(in_linear), translation(in_translation) {}
+	// Note: ignores the bottom row of the matrix, so it must be affine
+	explicit AffineTransform(const glm::mat4& M) :
+		linear(M), translation(M[3]) {}
+	~AffineTransform() = default;
+
+	// Columns are the (scaled) x, y, and z axes
+	glm::mat3 linear;
+	glm::vec3 translation;
+
+	glm::mat4 GetMatrix() const {
+		return glm::mat4(glm::vec4(linear[0], 0.0f), glm::vec4(linear[1], 0.0f),
+		                 glm::vec4(linear[2], 0.0f), glm::vec4(translation, 1.0f));
+	}
+
+	glm::vec3 TransformPoint(const glm::vec3& p) const {
+		return linear * p + translation;
+	}
+
+	glm::vec3 TransformVector(const glm::vec3& v) const {
+		return linear * v;
+	}
+
+	// Inverse transpose of the linear part, for transforming normals. Cheaper than a full
+	//   glm::inverse, since each column of the cofactor matrix is just a cross product
+	glm::mat3 GetNormalMatrix() const {
+		const glm::mat3 cofactors(glm::cross(linear[1], linear[2]),
+		                          glm::cross(linear[2], linear[0]),
+		                          glm::cross(linear[0], linear[1]));
+		const float det = glm::dot(linear[0], cofactors[0]);
+		return glm::mat3(cofactors[0] / det, cofactors[1] / det, cofactors[2] / det);
+	}
+
+	// Apply 'other' first, then this transform
+	AffineTransform operator*(const AffineTransform& other) const {
+		return AffineTransform(linear * other.linear, TransformPoint(other.translation));
+	}
+
+	// Find parent * local as a mat4, where 'parent' is an affine mat4 (i.e. a world matrix)
+	//   Works on the parent's vec4 columns directly, so there's no conversion in between
+	static void Compose(const glm::mat4& parent, const AffineTransform& local, glm::mat4& out) {
+		for (int i = 0; i < 3; ++i) {
+			const glm::vec3& col = local.linear[i];
+			out[i] = parent[0] * col.x + parent[1] * col.y + parent[2] * col.z;
+		}
+		const glm::vec3& t = local.translation;
+		out[3] = parent[0] * t.x + parent[1] * t.y + parent[2] * t.z + parent[3];
+	}
+};
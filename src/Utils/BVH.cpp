@@ -0,0 +1,65 @@
+#include <algorithm>
+
+#include "BVH.h"
+
+void BVH::Build(const std::vector<AABB>& boxes) {
+	nodes.clear();
+	itemIndices.resize(boxes.size());
+	for (uint32_t i = 0; i < (uint32_t)boxes.size(); ++i) {
+		itemIndices[i] = i;
+	}
+	if (boxes.empty()) {
+		return;
+	}
+	std::vector<glm::vec3> centers;
+	centers.reserve(boxes.size());
+	for (const AABB& box : boxes) {
+		centers.push_back(box.GetCenter());
+	}
+	// A binary tree with n leaves has 2n - 1 nodes
+	nodes.reserve(2 * (boxes.size() / MAX_LEAF_ITEMS + 1));
+	nodes.push_back(Node{ AABB(), 0, (uint32_t)boxes.size() });
+	Subdivide(0, boxes, centers);
+}
+
+void BVH::Subdivide(const uint32_t node_idx, const std::vector<AABB>& boxes,
+                    const std::vector<glm::vec3>& centers) {
+	// Note: nodes may be reallocated by the recursive calls, so don't keep references
+	const uint32_t first = nodes[node_idx].first;
+	const uint32_t count = nodes[node_idx].count;
+	AABB bounds;
+	AABB center_bounds;
+	for (uint32_t i = first; i < first + count; ++i) {
+		bounds.Expand(boxes[itemIndices[i]]);
+		center_bounds.Expand(centers[itemIndices[i]]);
+	}
+	nodes[node_idx].bounds = bounds;
+	if (count <= MAX_LEAF_ITEMS) {
+		return;
+	}
+
+	// Split at the median along the axis where the items' centers are most spread out,
+	//   which keeps the tree balanced
+	const glm::vec3 spread = center_bounds.max - center_bounds.min;
+	int axis = 0;
+	if (spread.y > spread[axis]) {
+		axis = 1;
+	}
+	if (spread.z > spread[axis]) {
+		axis = 2;
+	}
+	const uint32_t half = count / 2;
+	std::nth_element(itemIndices.begin() + first, itemIndices.begin() + first + half,
+	                 itemIndices.begin() + first + count,
+	                 [&centers, axis](const uint32_t a, const uint32_t b) {
+		return centers[a][axis] < centers[b][axis];
+	});
+
+	const uint32_t left_idx = (uint32_t)nodes.size();
+	nodes.push_back(Node{ AABB(), first, half });
+	nodes.push_back(Node{ AABB(), first + half, count - half });
+	nodes[node_idx].first = left_idx;
+	nodes[node_idx].count = 0;
+	Subdivide(left_idx, boxes, centers);
+	Subdivide(left_idx + 1, boxes, centers);
+}
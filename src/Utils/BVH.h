@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+///
+/// Bounding volume hierarchy over a fixed set of boxes, for finding which of many objects
+/// are in view without testing every one of them. Built once, so it's meant for objects
+/// that never move. Nodes are stored in a flat array, with each node's children next to
+/// each other
+///
+class BVH {
+public:
+	BVH() = default;
+	~BVH() = default;
+
+	// Rebuild the tree over 'boxes'. Queries report items as indices into this list
+	void Build(const std::vector<AABB>& boxes);
+
+	// Call visit(item) for every item in a leaf whose bounds intersect the frustum. Items
+	//   are only tested at node level, so callers should do their own per-item test
+	template <typename Visitor>
+	void Query(const Frustum& frustum, Visitor&& visit) const;
+
+	/* ----- Getters ----- */
+	size_t GetNumNodes() const { return nodes.size(); }
+	size_t GetNumItems() const { return itemIndices.size(); }
+
+private:
+	struct Node {
+		AABB bounds;
+		// Leaves: index of the first item in itemIndices. Interior nodes: index of the
+		//   left child (the right child is next to it)
+		uint32_t first;
+		// Number of items in a leaf, 0 for interior nodes
+		uint32_t count;
+	};
+	// Leaves with this many items or fewer aren't split further
+	static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+
+	// Split the items in [first, first + count) under node_idx, recursively
+	void Subdivide(const uint32_t node_idx, const std::vector<AABB>& boxes,
+	               const std::vector<glm::vec3>& centers);
+
+	std::vector<Node> nodes;
+	// Item indices, reordered so each leaf's items are contiguous
+	std::vector<uint32_t> itemIndices;
+};
+
+template <typename Visitor>
+void BVH::Query(const Frustum& frustum, Visitor&& visit) const {
+	if (nodes.empty()) {
+		return;
+	}
+	// Depth-first traversal with an explicit stack. The tree's depth is about
+	//   log2(items / MAX_LEAF_ITEMS), so 64 entries is plenty
+	uint32_t stack[64];
+	size_t stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0) {
+		const Node& node = nodes[stack[--stack_size]];
+		if (!frustum.Intersects(node.bounds)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				visit(itemIndices[i]);
+			}
+		}
+		else {
+			stack[stack_size++] = node.first;
+			stack[stack_size++] = node.first + 1;
+		}
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include "AffineTransform.h"
+
+///
+/// Axis-aligned bounding box. A default-constructed box is empty (min > max), and grows to
+/// fit whatever is added to it
+///
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB() :
+		min(std::numeric_limits<float>::max()),
+		max(-std::numeric_limits<float>::max()) {}
+	AABB(const glm::vec3& in_min, const glm::vec3& in_max) :
+		min(in_min), max(in_max) {}
+
+	// Has anything been added to this box?
+	bool IsValid() const {
+		return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+	}
+	glm::vec3 GetCenter() const { return 0.5f * (min + max); }
+	// Half of the box's size on each axis
+	glm::vec3 GetExtents() const { return 0.5f * (max - min); }
+
+	void Expand(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+	void Expand(const AABB& other) {
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	// Smallest box that contains this box after it's transformed. Each axis of the new
+	//   extents is the sum of the absolute projections of the old extents (Arvo's method),
+	//   so the 8 corners never have to be transformed individually
+	AABB Transformed(const AffineTransform& transform) const {
+		const glm::vec3 center = transform.TransformPoint(GetCenter());
+		const glm::vec3 extents = GetExtents();
+		glm::vec3 new_extents(0.0f);
+		for (int i = 0; i < 3; ++i) {
+			new_extents += glm::abs(transform.linear[i]) * extents[i];
+		}
+		return AABB(center - new_extents, center + new_extents);
+	}
+};
+
+///
+/// Bounding sphere. Looser than an AABB for most shapes, but cheaper to test
+///
+struct BoundingSphere {
+	glm::vec3 center;
+	float radius;
+
+	BoundingSphere() :
+		center(0.0f), radius(0.0f) {}
+	BoundingSphere(const glm::vec3& in_center, const float in_radius) :
+		center(in_center), radius(in_radius) {}
+
+	// Grow this sphere to also contain 'other'
+	void Expand(const BoundingSphere& other) {
+		const glm::vec3 offset = other.center - center;
+		const float dist = glm::length(offset);
+		if (dist + other.radius <= radius) {
+			return;
+		}
+		if (dist + radius <= other.radius) {
+			*this = other;
+			return;
+		}
+		// The new sphere touches the far side of both spheres
+		const float new_radius = 0.5f * (dist + radius + other.radius);
+		center += offset * ((new_radius - radius) / dist);
+		radius = new_radius;
+	}
+
+	// Sphere that contains this sphere after it's transformed. Non-uniform scale stretches
+	//   the sphere into an ellipsoid, so use the largest scale factor
+	BoundingSphere Transformed(const AffineTransform& transform) const {
+		const float max_scale_sq = std::max(glm::dot(transform.linear[0], transform.linear[0]),
+			std::max(glm::dot(transform.linear[1], transform.linear[1]),
+			         glm::dot(transform.linear[2], transform.linear[2])));
+		return BoundingSphere(transform.TransformPoint(center),
+		                      radius * std::sqrt(max_scale_sq));
+	}
+};
+
+///
+/// The 6 planes of a camera's view volume, with normals pointing inward. Planes are
+/// extracted from a view-projection matrix (Gribb & Hartmann), so they're in world space
+/// when built from P * V
+///
+class Frustum {
+public:
+	Frustum() = default;
+	explicit Frustum(const glm::mat4& view_proj) {
+		// Row i of the matrix (glm is column-major)
+		auto row = [&view_proj](const int i) {
+			return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+		};
+		// A point is inside when -w <= x, y, z <= w in clip space
+		planes[0] = row(3) + row(0); // left
+		planes[1] = row(3) - row(0); // right
+		planes[2] = row(3) + row(1); // bottom
+		planes[3] = row(3) - row(1); // top
+		planes[4] = row(3) + row(2); // near
+		planes[5] = row(3) - row(2); // far
+		// Normalize, so plane distances are real distances for the sphere test
+		for (glm::vec4& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	bool Intersects(const BoundingSphere& sphere) const {
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Conservative: boxes near the frustum's corners can pass without being visible
+	bool Intersects(const AABB& box) const {
+		for (const glm::vec4& plane : planes) {
+			// Corner of the box that's furthest along the plane's normal
+			const glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+			                       plane.y >= 0.0f ? box.max.y : box.min.y,
+			                       plane.z >= 0.0f ? box.max.z : box.min.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	// (normal, distance) for each plane
+	glm::vec4 planes[6];
+};
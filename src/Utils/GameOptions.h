@@ -24,6 +24,33 @@ public:
 			frameDelayMs = YAMLHelper::GetMapVal<unsigned int>(options_node, "frame_delay_ms");
 			showFramerate = YAMLHelper::GetMapVal<bool>(options_node, "show_frame_rate");
 			defaultModelPath = YAMLHelper::GetMapVal<std::string>(options_node,"default_model_path");
+			if (YAMLHelper::DoesMapHaveField(options_node, "physics_threads")) {
+				physicsThreads = YAMLHelper::GetMapVal<unsigned int>(options_node, "physics_threads");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "physics_thread")) {
+				physicsThread = YAMLHelper::GetMapVal<bool>(options_node, "physics_thread");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "asset_threads")) {
+				assetThreads = YAMLHelper::GetMapVal<unsigned int>(options_node, "asset_threads");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "asset_upload_budget_kb")) {
+				assetUploadBudgetKb =
+					YAMLHelper::GetMapVal<unsigned int>(options_node, "asset_upload_budget_kb");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "model_cache_budget_mb")) {
+				modelCacheBudgetMb =
+					YAMLHelper::GetMapVal<unsigned int>(options_node, "model_cache_budget_mb");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "texture_cache_budget_mb")) {
+				textureCacheBudgetMb =
+					YAMLHelper::GetMapVal<unsigned int>(options_node, "texture_cache_budget_mb");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "packed_vertices")) {
+				packedVertices = YAMLHelper::GetMapVal<bool>(options_node, "packed_vertices");
+			}
+			if (YAMLHelper::DoesMapHaveField(options_node, "show_render_stats")) {
+				showRenderStats = YAMLHelper::GetMapVal<bool>(options_node, "show_render_stats");
+			}
 		}
 		catch (std::exception& e) {
 			std::cerr << "ERROR - YAML parsing exception: " << e.what() << std::endl;
@@ -38,9 +65,29 @@ public:
 	glm::vec3 clearColor = glm::vec3(0.1f, 0.1f, 0.1f);
 	// Desired period for the physics updates
 	float physicsTimeStep = 1.0f / 60.0f;
+	// Should physics run on its own thread at a fixed rate? If not, the render thread runs
+	//   however many physics steps fit in each frame
+	bool physicsThread = false;
 	// Artificial delay on each rendering frame, for testing physics behavior
 	unsigned int frameDelayMs = 0;
 	// Should the framerate be printed to stdout?
 	bool showFramerate = false;
+	// Should the number of draws & binds in each frame be printed to stdout?
+	bool showRenderStats = false;
 	std::string defaultModelPath = "";
+	// Number of worker threads for physics updates (on top of the main thread).
+	//   0 picks one per hardware thread
+	unsigned int physicsThreads = 0;
+	// Number of threads that read asset files in the background. 0 uses half of the
+	//   hardware threads
+	unsigned int assetThreads = 0;
+	// Most asset data (in KB) uploaded to the GPU in a single frame
+	unsigned int assetUploadBudgetKb = 4096;
+	// Memory (in MB) that loaded models & textures can use before ones that aren't in the
+	//   scene anymore are freed. Models count their mesh data, and textures their GPU size
+	unsigned int modelCacheBudgetMb = 256;
+	unsigned int textureCacheBudgetMb = 512;
+	// Should meshes be stored with quantized vertices (see PackedVertex)? Halves the size of
+	//   vertex data, at the cost of some position precision on very large models
+	bool packedVertices = true;
 };
\ No newline at end of file
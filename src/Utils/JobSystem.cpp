@@ -0,0 +1,133 @@
+#include "JobSystem.h"
+
+namespace {
+// Which JobSystem (if any) owns the current thread, and the thread's queue in it
+thread_local const JobSystem* current_system = nullptr;
+thread_local size_t current_thread_idx = 0;
+} // namespace
+
+JobSystem::JobSystem(size_t num_workers) {
+	if (num_workers == 0) {
+		// hardware_concurrency can return 0 if it isn't known
+		const size_t num_hw_threads = std::thread::hardware_concurrency();
+		num_workers = (num_hw_threads > 1) ? num_hw_threads - 1 : 1;
+	}
+	for (size_t i = 0; i < num_workers + 1; ++i) {
+		queues.emplace_back(std::make_unique<WorkQueue>());
+	}
+	current_system = this;
+	current_thread_idx = 0;
+	for (size_t i = 1; i <= num_workers; ++i) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (current_system == this) {
+		current_system = nullptr;
+	}
+}
+
+void JobSystem::Submit(Job job, Counter& counter) {
+	counter.remaining.fetch_add(1, std::memory_order_relaxed);
+	// Count the task before it's visible to thieves, so the count never drops below 0.
+	//   Update it under the sleep mutex, so a worker can't check it and then go to sleep
+	//   after the notify has already been sent
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		numQueued.fetch_add(1);
+	}
+	WorkQueue& queue = *queues[GetThreadIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		Task task;
+		task.job = std::move(job);
+		task.counter = &counter;
+		queue.tasks.emplace_back(std::move(task));
+	}
+	wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(Counter& counter) {
+	const size_t thread_idx = GetThreadIndex();
+	while (counter.remaining.load(std::memory_order_acquire) > 0) {
+		// Help out instead of blocking. If there's nothing left to take, the remaining
+		//   jobs are already running on other threads
+		if (!TryRunTask(thread_idx)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(const size_t count, const std::function<void(size_t)>& job) {
+	if (count == 0) {
+		return;
+	}
+	Counter counter;
+	for (size_t i = 1; i < count; ++i) {
+		Submit([&job, i]() { job(i); }, counter);
+	}
+	job(0);
+	Wait(counter);
+}
+
+size_t JobSystem::GetThreadIndex() const {
+	return (current_system == this) ? current_thread_idx : 0;
+}
+
+bool JobSystem::TryGetTask(const size_t thread_idx, Task& out_task) {
+	// Newest task from this thread's own queue
+	{
+		WorkQueue& queue = *queues[thread_idx];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			out_task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			numQueued.fetch_sub(1);
+			return true;
+		}
+	}
+	// Otherwise, steal the oldest task from the next thread that has one
+	const size_t num_queues = queues.size();
+	for (size_t offset = 1; offset < num_queues; ++offset) {
+		WorkQueue& queue = *queues[(thread_idx + offset) % num_queues];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			out_task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			numQueued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::TryRunTask(const size_t thread_idx) {
+	Task task;
+	if (!TryGetTask(thread_idx, task)) {
+		return false;
+	}
+	task.job();
+	// Release, so the job's writes are visible to whoever sees the counter reach 0
+	task.counter->remaining.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::WorkerLoop(const size_t thread_idx) {
+	current_system = this;
+	current_thread_idx = thread_idx;
+	while (!stopping) {
+		if (!TryRunTask(thread_idx)) {
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wakeCondition.wait(lock, [this]() { return stopping || numQueued > 0; });
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+/// Small work-stealing job system. Every thread (the thread that created the system, plus
+/// the worker threads) owns a deque of jobs. A thread pushes and pops jobs at the back of
+/// its own deque, so recently-submitted (cache-warm) work runs first, and idle threads steal
+/// from the front of other threads' deques. Jobs may submit more jobs.
+///
+/// Ordering: every job tracked by a Counter happens-before Wait() on that Counter returns,
+/// so anything the jobs wrote is visible to the waiting thread afterward. Jobs that run
+/// at the same time have no ordering between them, so they must not touch the same data.
+///
+class JobSystem {
+public:
+	typedef std::function<void()> Job;
+
+	// Number of submitted jobs that haven't finished yet. Pass the same Counter to Submit
+	//   for a group of jobs, then Wait on it
+	class Counter {
+	public:
+		Counter() = default;
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+
+	private:
+		friend class JobSystem;
+		std::atomic<size_t> remaining{ 0 };
+	};
+
+	// Start num_workers worker threads. 0 uses one worker per hardware thread, minus one
+	//   for the calling thread (which also runs jobs while it waits)
+	JobSystem(size_t num_workers = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queue a job on the calling thread's deque
+	void Submit(Job job, Counter& counter);
+	// Block until every job tracked by 'counter' is done. The calling thread runs (or
+	//   steals) queued jobs while it waits, so it's safe to call from inside a job
+	void Wait(Counter& counter);
+	// Run job(i) for every i in [0, count) and wait for all of them. Index 0 runs on the
+	//   calling thread, after the rest have been queued
+	void ParallelFor(const size_t count, const std::function<void(size_t)>& job);
+
+	/* ----- Getters ----- */
+	// Number of threads that run jobs, including the thread that created the system
+	size_t GetNumThreads() const { return queues.size(); }
+
+private:
+	struct Task {
+		Job job;
+		Counter* counter = nullptr;
+	};
+	// A thread's own deque. Guarded by a mutex, since jobs are coarse (i.e. a whole
+	//   object subtree), so contention is rare and a lock-free deque isn't worth it
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// Index of the calling thread's queue. Threads outside this system share queue 0
+	size_t GetThreadIndex() const;
+	// Pop a task from this thread's queue, or steal one from another thread. Returns
+	//   false if every queue is empty
+	bool TryGetTask(const size_t thread_idx, Task& out_task);
+	// Find and run one task. Returns false if there was nothing to run
+	bool TryRunTask(const size_t thread_idx);
+	void WorkerLoop(const size_t thread_idx);
+
+	// One queue per thread. Queue 0 belongs to the thread that created the system
+	std::vector<std::unique_ptr<WorkQueue> > queues;
+	std::vector<std::thread> workers;
+	// Total number of tasks sitting in any queue, so idle workers know when to wake up
+	std::atomic<size_t> numQueued{ 0 };
+	std::atomic<bool> stopping{ false };
+	// Idle workers sleep on this instead of spinning
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+};
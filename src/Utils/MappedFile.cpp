@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const uint8_t*)view;
+	size = (size_t)file_size.QuadPart;
+#else
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file, so the descriptor isn't needed
+	close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	data = (const uint8_t*)view;
+	size = (size_t)file_stat.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::Close() {
+	if (!data) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mappingHandle);
+	CloseHandle((HANDLE)fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::GetFileInfo(const std::string& filename, uint64_t& size,
+                             int64_t& mod_time) {
+#ifdef _WIN32
+	struct _stat64 file_stat;
+	if (_stat64(filename.c_str(), &file_stat) != 0) {
+		return false;
+	}
+#else
+	struct stat file_stat;
+	if (stat(filename.c_str(), &file_stat) != 0) {
+		return false;
+	}
+#endif
+	size = (uint64_t)file_stat.st_size;
+	mod_time = (int64_t)file_stat.st_mtime;
+	return true;
+}
+
+bool MappedFile::MoveIntoPlace(const std::string& temp_path, const std::string& path) {
+#ifdef _WIN32
+	// Fails while another MappedFile has 'path' open, since it's opened without
+	//   FILE_SHARE_DELETE. The old file stays valid, so that's safe to treat as a failure
+	const bool moved = MoveFileExA(temp_path.c_str(), path.c_str(),
+	                               MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	// Replaces the name only, so existing mappings keep reading the old file's contents
+	const bool moved = rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+	if (!moved) {
+		remove(temp_path.c_str());
+	}
+	return moved;
+}
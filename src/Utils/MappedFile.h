@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///
+/// Read-only memory mapping of a whole file. The OS pages the file in as it's read, so
+/// nothing is copied into a separate buffer. The data stays valid until the MappedFile is
+/// closed or destroyed
+///
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+	// Owns the mapping, so copying would unmap it twice
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map a file, closing whatever was mapped before. Returns false if the file can't be
+	//   opened or is empty
+	bool Open(const std::string& filename);
+	void Close();
+
+	// Size & last modification time (in seconds) of a file, without opening it. Returns
+	//   false if the file doesn't exist
+	static bool GetFileInfo(const std::string& filename, uint64_t& size, int64_t& mod_time);
+	// Move a finished file over 'path' in one step. Anyone who already has 'path' mapped
+	//   keeps the old contents, instead of seeing the file truncated while it's rewritten.
+	//   On failure, temp_path is deleted and 'path' is left as it was
+	static bool MoveIntoPlace(const std::string& temp_path, const std::string& path);
+
+	/* ----- Getters ----- */
+	bool IsOpen() const { return data != nullptr; }
+	const uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	// HANDLEs for the file and its mapping object, kept as void* to keep windows.h out of
+	//   this header
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
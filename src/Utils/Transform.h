@@ -6,9 +6,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include "AffineTransform.h"
+
 /// 
 /// Helper class for defining transforms and misc transform operations
 ///
+/// The rotation matrix is cached, and only rebuilt when 'rot' has changed since the last time
+/// it was needed. Note: the cache is filled in by const functions, so a single Transform must
+/// not be read from several threads at once
+///
 class Transform {
 public:
 	inline static glm::quat EulerToQuat(const glm::vec3 euler) {
@@ -22,11 +28,14 @@ public:
 		loc(0.0f, 0.0f, 0.0f),
 		// Note: quat constructor is (w, x, y, z)
 		rot(1.0f, 0.0f, 0.0f, 0.0f),
-		scale(1.0f, 1.0f, 1.0f) {}
+		scale(1.0f, 1.0f, 1.0f),
+		cachedRot(rot),
+		rotBasis(1.0f) {}
 	Transform(glm::vec3 in_loc, glm::quat in_rot, glm::vec3 in_scale) :
-		loc(in_loc), rot(in_rot), scale(in_scale) {}
+		loc(in_loc), rot(in_rot), scale(in_scale), cachedRot(rot), rotBasis(glm::mat3_cast(rot)) {}
 	Transform(glm::vec3 in_loc, glm::vec3 in_rot, glm::vec3 in_scale) :
-		loc(in_loc), rot(EulerToQuat(in_rot)), scale(in_scale) {}
+		loc(in_loc), rot(EulerToQuat(in_rot)), scale(in_scale), cachedRot(rot),
+		rotBasis(glm::mat3_cast(rot)) {}
 	~Transform() = default;
 
 	// loc, rot, and scale w.r.t a parent object
@@ -34,27 +43,38 @@ public:
 	glm::quat rot;
 	glm::vec3 scale;
 
+	// Same as translate * mat4_cast(rot) * scale, but built directly from the rotation basis
 	glm::mat4 GetMatrix() const {
-		glm::mat4 M(1.0f);
-		M = glm::translate(M, loc);
-		M *= glm::mat4_cast(rot);
-		M = glm::scale(M, scale);
-		return M;
+		return GetAffine().GetMatrix();
+	}
+
+	AffineTransform GetAffine() const {
+		const glm::mat3& R = GetRotationBasis();
+		return AffineTransform(glm::mat3(R[0] * scale.x, R[1] * scale.y, R[2] * scale.z), loc);
+	}
+
+	// Rotation matrix of 'rot', with the right, up, and forward vectors as its columns
+	const glm::mat3& GetRotationBasis() const {
+		if (rot != cachedRot) {
+			rotBasis = glm::mat3_cast(rot);
+			cachedRot = rot;
+		}
+		return rotBasis;
 	}
 
 	glm::vec3 GetRightVector() const {
 		// Right vector is stored in the 1st column of the rotation matrix
-		return glm::mat4_cast(rot)[0];
+		return GetRotationBasis()[0];
 	}
 
 	glm::vec3 GetUpVector() const {
 		// Up vector is stored in the 2nd column of the rotation matrix
-		return glm::mat4_cast(rot)[1];
+		return GetRotationBasis()[1];
 	}
 
 	glm::vec3 GetForwardVector() const {
 		// Forward vector is stored in the 3rd column of the rotation matrix
-		return glm::mat4_cast(rot)[2];
+		return GetRotationBasis()[2];
 	}
 
 	void AddRotationOffset(const float angle, const glm::vec3& axis) {
@@ -63,6 +83,9 @@ public:
 
 	friend std::ostream& operator<<(std::ostream& os, const Transform& t);
 private:
+	// Value of 'rot' when rotBasis was last built
+	mutable glm::quat cachedRot;
+	mutable glm::mat3 rotBasis;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Transform& t) {
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cassert>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "TransformSystem.h"
+
+namespace {
+// Blend two affine matrices by splitting them into translation, rotation, and scale, so
+//   rotating objects don't shrink halfway between snapshots like a plain lerp would.
+//   Shear (from non-uniform scale under a rotated parent) isn't preserved
+glm::mat4 InterpolateAffine(const glm::mat4& a, const glm::mat4& b, const float alpha) {
+	glm::vec3 scale_a, scale_b;
+	glm::mat3 rot_a, rot_b;
+	for (int i = 0; i < 3; ++i) {
+		scale_a[i] = glm::length(glm::vec3(a[i]));
+		scale_b[i] = glm::length(glm::vec3(b[i]));
+		rot_a[i] = glm::vec3(a[i]) / scale_a[i];
+		rot_b[i] = glm::vec3(b[i]) / scale_b[i];
+	}
+	const glm::quat rot = glm::slerp(glm::quat_cast(rot_a), glm::quat_cast(rot_b), alpha);
+	const glm::vec3 scale = glm::mix(scale_a, scale_b, alpha);
+	const glm::mat3 R = glm::mat3_cast(rot);
+	return AffineTransform(glm::mat3(R[0] * scale.x, R[1] * scale.y, R[2] * scale.z),
+	                       glm::mix(glm::vec3(a[3]), glm::vec3(b[3]), alpha)).GetMatrix();
+}
+} // namespace
+
+constexpr TransformSystem::Handle TransformSystem::INVALID_HANDLE;
+constexpr uint32_t TransformSystem::NO_SLOT;
+
+TransformSystem::Handle TransformSystem::CreateNode() {
+	Handle node;
+	if (!freeHandles.empty()) {
+		node = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else {
+		node = (Handle)handleSlots.size();
+		handleSlots.emplace_back(NO_SLOT);
+		handleParents.emplace_back(INVALID_HANDLE);
+	}
+	// New nodes are roots, so appending them never breaks the order
+	const uint32_t slot = (uint32_t)locals.size();
+	handleSlots[node] = slot;
+	handleParents[node] = INVALID_HANDLE;
+	locals.emplace_back();
+	worlds.emplace_back(1.0f);
+	parentSlots.emplace_back(NO_SLOT);
+	worldVersions.emplace_back(0);
+	parentVersions.emplace_back(0);
+	localDirty.emplace_back(0);
+	worldOverridden.emplace_back(0);
+	slotHandles.emplace_back(node);
+	return node;
+}
+
+void TransformSystem::DestroyNode(const Handle node) {
+	assert(node < handleSlots.size() && handleSlots[node] != NO_SLOT);
+	// Leave the slot in place until the next rebuild. Children keep reading its last world
+	//   matrix until then
+	slotHandles[handleSlots[node]] = INVALID_HANDLE;
+	handleSlots[node] = NO_SLOT;
+	pendingFree.emplace_back(node);
+	orderDirty = true;
+	++hierarchyVersion;
+}
+
+void TransformSystem::SetParent(const Handle node, const Handle parent) {
+	const uint32_t slot = handleSlots[node];
+	const uint32_t parent_slot = (parent == INVALID_HANDLE) ? NO_SLOT : handleSlots[parent];
+	handleParents[node] = parent;
+	parentSlots[slot] = parent_slot;
+	localDirty[slot] = 1;
+	++hierarchyVersion;
+	// Only this edge can break the order, since every other parent/child pair is unchanged
+	if (parent_slot != NO_SLOT && parent_slot > slot) {
+		orderDirty = true;
+	}
+}
+
+void TransformSystem::UpdateWorldMatrices() {
+	if (orderDirty) {
+		RebuildOrder();
+	}
+	const uint32_t num_slots = (uint32_t)locals.size();
+	for (uint32_t slot = 0; slot < num_slots; ++slot) {
+		UpdateSlot(slot);
+	}
+}
+
+void TransformSystem::PublishSnapshot(const double time) {
+	stagingSnapshot.resize(handleSlots.size(), glm::mat4(1.0f));
+	for (Handle node = 0; node < handleSlots.size(); ++node) {
+		const uint32_t slot = handleSlots[node];
+		if (slot != NO_SLOT) {
+			stagingSnapshot[node] = worlds[slot];
+		}
+	}
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	if (latestSnapshot.empty()) {
+		// Nothing to blend from yet, so both snapshots start out the same
+		previousSnapshot = stagingSnapshot;
+		previousSnapshotTime = time;
+	}
+	else {
+		previousSnapshot.swap(latestSnapshot);
+		previousSnapshotTime = latestSnapshotTime;
+	}
+	// Staging gets the oldest snapshot's storage, which is overwritten by the next publish
+	latestSnapshot.swap(stagingSnapshot);
+	latestSnapshotTime = time;
+}
+
+void TransformSystem::InterpolateSnapshots(const double time) {
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	float alpha = 1.0f;
+	if (latestSnapshotTime > previousSnapshotTime) {
+		alpha = (float)((time - previousSnapshotTime) /
+		                (latestSnapshotTime - previousSnapshotTime));
+		alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+	}
+	renderMatrices.resize(latestSnapshot.size());
+	for (size_t node = 0; node < latestSnapshot.size(); ++node) {
+		const glm::mat4& latest = latestSnapshot[node];
+		// Most objects (i.e. static ones) didn't move, so skip blending them. Nodes that are
+		//   newer than the previous snapshot have nothing to blend from
+		if (alpha == 1.0f || node >= previousSnapshot.size() ||
+		    previousSnapshot[node] == latest) {
+			renderMatrices[node] = latest;
+		}
+		else {
+			renderMatrices[node] = InterpolateAffine(previousSnapshot[node], latest, alpha);
+		}
+	}
+}
+
+const Transform& TransformSystem::GetLocalTransform(const Handle node) const {
+	return locals[handleSlots[node]];
+}
+
+const glm::mat4& TransformSystem::GetWorldMatrix(const Handle node) {
+	const uint32_t slot = handleSlots[node];
+	ResolveSlot(slot);
+	return worlds[slot];
+}
+
+uint32_t TransformSystem::GetWorldVersion(const Handle node) {
+	const uint32_t slot = handleSlots[node];
+	ResolveSlot(slot);
+	return worldVersions[slot];
+}
+
+const glm::mat4& TransformSystem::GetRenderMatrix(const Handle node) const {
+	static const glm::mat4 identity(1.0f);
+	if (node >= renderMatrices.size()) {
+		return identity;
+	}
+	return renderMatrices[node];
+}
+
+TransformSystem::Handle TransformSystem::GetParent(const Handle node) const {
+	return handleParents[node];
+}
+
+size_t TransformSystem::GetNumNodes() const {
+	return handleSlots.size() - freeHandles.size() - pendingFree.size();
+}
+
+uint32_t TransformSystem::GetHierarchyVersion() const {
+	return hierarchyVersion;
+}
+
+Transform& TransformSystem::GetMutableLocalTransform(const Handle node) {
+	const uint32_t slot = handleSlots[node];
+	localDirty[slot] = 1;
+	return locals[slot];
+}
+
+void TransformSystem::SetWorldMatrix(const Handle node, const glm::mat4& world) {
+	const uint32_t slot = handleSlots[node];
+	worlds[slot] = world;
+	++worldVersions[slot];
+	worldOverridden[slot] = 1;
+	localDirty[slot] = 0;
+}
+
+void TransformSystem::UpdateSlot(const uint32_t slot) {
+	// Destroyed nodes and overridden world matrices are left alone
+	if (slotHandles[slot] == INVALID_HANDLE || worldOverridden[slot]) {
+		return;
+	}
+	const uint32_t parent_slot = parentSlots[slot];
+	if (parent_slot == NO_SLOT) {
+		if (localDirty[slot]) {
+			worlds[slot] = locals[slot].GetMatrix();
+			++worldVersions[slot];
+			localDirty[slot] = 0;
+		}
+	}
+	else if (localDirty[slot] || parentVersions[slot] != worldVersions[parent_slot]) {
+		AffineTransform::Compose(worlds[parent_slot], locals[slot].GetAffine(), worlds[slot]);
+		++worldVersions[slot];
+		parentVersions[slot] = worldVersions[parent_slot];
+		localDirty[slot] = 0;
+	}
+}
+
+void TransformSystem::ResolveSlot(const uint32_t slot) {
+	// Hierarchies are shallow, so recursing up to the root is fine
+	if (parentSlots[slot] != NO_SLOT) {
+		ResolveSlot(parentSlots[slot]);
+	}
+	UpdateSlot(slot);
+}
+
+void TransformSystem::RebuildOrder() {
+	const size_t num_handles = handleSlots.size();
+	// Detach any node whose parent was destroyed
+	for (Handle node = 0; node < num_handles; ++node) {
+		const Handle parent = handleParents[node];
+		if (handleSlots[node] != NO_SLOT && parent != INVALID_HANDLE &&
+		    handleSlots[parent] == NO_SLOT) {
+			handleParents[node] = INVALID_HANDLE;
+			localDirty[handleSlots[node]] = 1;
+		}
+	}
+	freeHandles.insert(freeHandles.end(), pendingFree.begin(), pendingFree.end());
+	pendingFree.clear();
+
+	// Find the depth of every live node, then sort by depth. Parents are always shallower
+	//   than their children, and the stable sort keeps siblings close to where they were
+	std::vector<uint32_t> depths(num_handles, 0);
+	std::vector<Handle> order;
+	order.reserve(locals.size());
+	for (uint32_t slot = 0; slot < locals.size(); ++slot) {
+		const Handle node = slotHandles[slot];
+		if (node == INVALID_HANDLE) {
+			continue;
+		}
+		uint32_t depth = 0;
+		for (Handle p = handleParents[node]; p != INVALID_HANDLE; p = handleParents[p]) {
+			++depth;
+		}
+		depths[node] = depth;
+		order.emplace_back(node);
+	}
+	std::stable_sort(order.begin(), order.end(), [&depths](const Handle a, const Handle b) {
+		return depths[a] < depths[b];
+	});
+
+	// Move every live node into its new slot
+	const size_t num_slots = order.size();
+	std::vector<Transform> new_locals(num_slots);
+	std::vector<glm::mat4> new_worlds(num_slots);
+	std::vector<uint32_t> new_world_versions(num_slots);
+	std::vector<uint32_t> new_parent_versions(num_slots);
+	std::vector<char> new_local_dirty(num_slots);
+	std::vector<char> new_world_overridden(num_slots);
+	for (uint32_t new_slot = 0; new_slot < num_slots; ++new_slot) {
+		const uint32_t old_slot = handleSlots[order[new_slot]];
+		new_locals[new_slot] = locals[old_slot];
+		new_worlds[new_slot] = worlds[old_slot];
+		new_world_versions[new_slot] = worldVersions[old_slot];
+		new_parent_versions[new_slot] = parentVersions[old_slot];
+		new_local_dirty[new_slot] = localDirty[old_slot];
+		new_world_overridden[new_slot] = worldOverridden[old_slot];
+	}
+	for (uint32_t new_slot = 0; new_slot < num_slots; ++new_slot) {
+		handleSlots[order[new_slot]] = new_slot;
+	}
+	parentSlots.assign(num_slots, NO_SLOT);
+	for (uint32_t new_slot = 0; new_slot < num_slots; ++new_slot) {
+		const Handle parent = handleParents[order[new_slot]];
+		if (parent != INVALID_HANDLE) {
+			parentSlots[new_slot] = handleSlots[parent];
+		}
+	}
+	locals.swap(new_locals);
+	worlds.swap(new_worlds);
+	worldVersions.swap(new_world_versions);
+	parentVersions.swap(new_parent_versions);
+	localDirty.swap(new_local_dirty);
+	worldOverridden.swap(new_world_overridden);
+	slotHandles.swap(order);
+	orderDirty = false;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Transform.h"
+
+///
+/// Flat storage for the transforms of every SceneObject. Local transforms, parent links and
+/// world matrices live in parallel arrays that are kept in topological order (every parent
+/// before its children), so UpdateWorldMatrices refreshes the whole hierarchy in a single
+/// linear pass, without chasing any pointers.
+///
+/// Objects refer to their node through a Handle, which stays valid while the arrays are
+/// re-sorted. Each node counts how many times its world matrix has changed, and remembers
+/// which version of its parent's world matrix it was built from, so a node whose parent
+/// moved is stale without anyone having to mark it.
+///
+/// GetWorldMatrix can be called at any time (i.e. in the middle of a physics update), and
+/// brings the node and its ancestors up to date first. Nodes in separate subtrees can be
+/// read and written from different threads, but creating, destroying or re-parenting nodes
+/// must only happen on one thread at a time.
+///
+/// Rendering reads snapshots instead of the live matrices, so physics can run on its own
+/// thread. After each physics step, PublishSnapshot copies every world matrix into the
+/// newest snapshot. Before each frame, InterpolateSnapshots blends the last two snapshots
+/// into the matrices returned by GetRenderMatrix, so motion stays smooth when frames and
+/// physics steps don't line up.
+///
+class TransformSystem {
+public:
+	typedef uint32_t Handle;
+	static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+	TransformSystem() = default;
+	~TransformSystem() = default;
+
+	// Add a new root node with an identity transform
+	Handle CreateNode();
+	// Remove a node. Any children become root nodes
+	void DestroyNode(const Handle node);
+	// Attach a node to a new parent, or detach it by passing INVALID_HANDLE
+	void SetParent(const Handle node, const Handle parent);
+
+	// Bring every stale world matrix up to date in one pass. If the hierarchy changed since
+	//   the last pass, the nodes are re-sorted first
+	void UpdateWorldMatrices();
+
+	/* ----- Snapshots for rendering ----- */
+	// Copy every world matrix into a new snapshot of the scene at 'time' (in seconds), and
+	//   keep the previous one for blending. Call after UpdateWorldMatrices, on the thread
+	//   that runs physics
+	void PublishSnapshot(const double time);
+	// Blend the last two snapshots into the render matrices for a frame at 'time'. Times
+	//   outside the two snapshots are clamped to the nearest one. Call once per frame, on
+	//   the render thread
+	void InterpolateSnapshots(const double time);
+
+	/* ----- Getters ----- */
+	const Transform& GetLocalTransform(const Handle node) const;
+	// Note: the reference is only valid until the next node is created or the next call to
+	//   UpdateWorldMatrices, so copy the matrix if it needs to be kept
+	const glm::mat4& GetWorldMatrix(const Handle node);
+	// Number of times the node's world matrix has changed. Brings the node up to date first,
+	//   so comparing against an earlier version tells whether the node (or any ancestor)
+	//   has moved since then
+	uint32_t GetWorldVersion(const Handle node);
+	// World matrix of the node in the frame being drawn (see InterpolateSnapshots). Safe
+	//   to call while physics runs on another thread. Identity for nodes that were created
+	//   after the last snapshot
+	const glm::mat4& GetRenderMatrix(const Handle node) const;
+	// Parent of the node, or INVALID_HANDLE for root nodes
+	Handle GetParent(const Handle node) const;
+	size_t GetNumNodes() const;
+	// Number of times a node has been re-parented or destroyed. Anything that caches the
+	//   shape of the hierarchy can compare against this to tell when to rebuild
+	uint32_t GetHierarchyVersion() const;
+
+	/* ----- Setters ----- */
+	// Mutable access to a node's local transform. Marks the node's world matrix as stale
+	Transform& GetMutableLocalTransform(const Handle node);
+	// Take over a node's world matrix. From then on, the node's world matrix only changes
+	//   through this function, ignoring its parent and local transform. Its children still
+	//   follow it as usual. Note: the matrix must be affine, since children are composed
+	//   with it through AffineTransform
+	void SetWorldMatrix(const Handle node, const glm::mat4& world);
+
+private:
+	static constexpr uint32_t NO_SLOT = 0xFFFFFFFF;
+
+	// Recompute a slot's world matrix if it's stale, assuming its parent's is up to date
+	void UpdateSlot(const uint32_t slot);
+	// Bring a slot's ancestors up to date (root first), then the slot itself
+	void ResolveSlot(const uint32_t slot);
+	// Re-sort the slots so that parents come before children, and drop destroyed nodes
+	void RebuildOrder();
+
+	/* ----- Per-slot data, in topological order ----- */
+	std::vector<Transform> locals;
+	std::vector<glm::mat4> worlds;
+	std::vector<uint32_t> parentSlots;
+	// Number of times each world matrix has changed
+	std::vector<uint32_t> worldVersions;
+	// Version of the parent's world matrix that each world matrix was built from
+	std::vector<uint32_t> parentVersions;
+	// Has the local transform (or the parent) changed since the world matrix was built?
+	//   Stored as chars, since vector<bool> is bit-packed and unsafe to write from
+	//   separate threads
+	std::vector<char> localDirty;
+	// Is the world matrix set directly through SetWorldMatrix?
+	std::vector<char> worldOverridden;
+	// Handle of the node in each slot, or INVALID_HANDLE if the node was destroyed
+	std::vector<Handle> slotHandles;
+
+	/* ----- Per-handle data ----- */
+	// Slot of each node, or NO_SLOT if the node was destroyed
+	std::vector<uint32_t> handleSlots;
+	// Parent of each node. Kept by handle, so the order can be rebuilt from it
+	std::vector<Handle> handleParents;
+	// Handles that can be given out again. Destroyed handles wait in pendingFree until the
+	//   next rebuild, so that nodes still pointing at them can be detached first
+	std::vector<Handle> freeHandles;
+	std::vector<Handle> pendingFree;
+
+	// Did the hierarchy change in a way that broke the topological order?
+	bool orderDirty = false;
+	uint32_t hierarchyVersion = 0;
+
+	/* ----- Snapshots, by handle ----- */
+	// Filled in by PublishSnapshot without holding the lock, then swapped in
+	std::vector<glm::mat4> stagingSnapshot;
+	// Guards the two published snapshots and their times
+	std::mutex snapshotMutex;
+	std::vector<glm::mat4> previousSnapshot;
+	std::vector<glm::mat4> latestSnapshot;
+	double previousSnapshotTime = 0.0;
+	double latestSnapshotTime = 0.0;
+	// Output of InterpolateSnapshots. Only touched by the render thread
+	std::vector<glm::mat4> renderMatrices;
+};
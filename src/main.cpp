@@ -32,5 +32,8 @@ int main(int argc, char** argv) {
 		// Render the entire scene
 		spider_game->RenderScene(delta_time);
 	}
+	// Physics steps hold references to the engine, so the physics thread has to stop
+	//   before the engine can be destroyed
+	spider_game->StopPhysics();
 	return 0;
 }
\ No newline at end of file